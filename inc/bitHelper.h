@@ -79,6 +79,27 @@ static constexpr uint64 MoveDownLeft(uint64 pos)
 static constexpr uint64 MoveDownRight(uint64 pos)    
     { return (pos & ~(U64Walls::Bottom | U64Walls::Right)) >> 7; }
 
+// Squares attacked by every knight in pos, whatever is on them.
+static constexpr uint64 GetKnightAttacks(uint64 pos)
+{
+    const uint64 movedUp    = MoveUp(pos);
+    const uint64 movedLeft  = MoveLeft(pos);
+    const uint64 movedRight = MoveRight(pos);
+    const uint64 movedDown  = MoveDown(pos);
+
+    return MoveUpRight(movedUp)     | MoveUpLeft(movedUp)      |
+           MoveUpLeft(movedLeft)    | MoveDownLeft(movedLeft)  |
+           MoveUpRight(movedRight)  | MoveDownRight(movedRight)|
+           MoveDownLeft(movedDown)  | MoveDownRight(movedDown);
+}
+
+// Squares attacked by a king on pos, whatever is on them.
+static constexpr uint64 GetKingAttacks(uint64 pos)
+{
+    return MoveUp(pos)     | MoveLeft(pos)      | MoveRight(pos)    | MoveDown(pos) |
+           MoveUpLeft(pos) | MoveUpRight(pos)   | MoveDownLeft(pos) | MoveDownRight(pos);
+}
+
 
 
 // Moves piece by N, returns 0 for bits that wrap around the board
@@ -1,9 +1,14 @@
 #pragma once
 #include "util.h"
+#include "sliderAttacks.h"
+#include "pieceSquareTables.h"
+#include "pawnHashTable.h"
+#include "nnue.h"
 #include <string>
 #include <vector>
+#include <type_traits>
 
-enum Piece : uint32
+enum Piece : uint8
 {
     wKing         = 0,
     wQueen        = 1,
@@ -44,9 +49,6 @@ enum PieceScores : int32
     FarPassedPawnScore    =  PawnScore / 2,     // extra points for passed pawns
     MidPassedPawnScore    =  PawnScore,
     ClosePassedPawnScore  =  PawnScore * 2,
-    FarPawnAdvanceScore   =  -5,            // Lose points for unpushed pawns
-    MidPawnAdvanceScore   =   5,
-    ClosePawnAdvanceScore =  20,
 
     GeneralMobilityScore  =   1,            // Points for having legal moves
 
@@ -75,8 +77,77 @@ constexpr int32 PieceValueArray[] = { PieceScores::KingScore,
 constexpr int32 RookAdjustmentScores[]   = { 15,  12,  9, 6, 3, 0, -3, -6, -9};
 constexpr int32 KnightAdjustmentScores[] = {-15, -10, -5, 0, 4, 8, 12,  15, 20};
 
-// This will be passed pawn pushes, promotions, castles, and maybe some other stuff.
-constexpr uint32 MaxNumProbablyGoodMoves = 16;
+// The piece square tables for every piece, black's negated the same as PieceValueArray so the
+// make functions only ever add and subtract entries.  The NoPiece rows are 0, so taking a capture
+// of nothing off costs nothing.
+struct PieceSquareScores
+{
+    int16 midgame[Piece::PieceCount][64];
+    int16 endgame[Piece::PieceCount][64];
+};
+
+constexpr PieceSquareScores BuildPieceSquareScores()
+{
+    const int16* const midgameTables[] = { KingMidgameTable, QueenTable, RookMidgameTable,
+                                           KnightTable,      BishopTable, PawnMidgameTable };
+    const int16* const endgameTables[] = { KingEndgameTable, QueenTable, RookEndgameTable,
+                                           KnightTable,      BishopTable, PawnEndgameTable };
+
+    PieceSquareScores scores = {};
+    for (uint32 piece = Piece::wKing; piece <= Piece::wPawn; piece++)
+    {
+        for (uint32 idx = 0; idx < 64; idx++)
+        {
+            scores.midgame[piece][idx]     = midgameTables[piece][idx ^ 56];
+            scores.endgame[piece][idx]     = endgameTables[piece][idx ^ 56];
+            scores.midgame[piece + 6][idx] = -midgameTables[piece][idx];
+            scores.endgame[piece + 6][idx] = -endgameTables[piece][idx];
+        }
+    }
+    return scores;
+}
+
+inline constexpr PieceSquareScores PieceSquareTable = BuildPieceSquareScores();
+
+// Zobrist keys for BoardInfo::pawnKey.  Only the pawn rows are set, so the make functions can xor
+// in the from, to and captured pieces whatever they are, and only pawns change the key.
+struct PawnZobristKeys
+{
+    uint64 keys[Piece::PieceCount][64];
+};
+
+constexpr PawnZobristKeys BuildPawnZobristKeys()
+{
+    // splitmix64, which is enough to give every pawn square its own well mixed key.
+    uint64 state = 0x9E3779B97F4A7C15ull;
+
+    PawnZobristKeys pawnKeys = {};
+    for (Piece piece : { Piece::wPawn, Piece::bPawn })
+    {
+        for (uint32 idx = 0; idx < 64; idx++)
+        {
+            state += 0x9E3779B97F4A7C15ull;
+            uint64 key = state;
+            key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+            key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+            pawnKeys.keys[piece][idx] = key ^ (key >> 31);
+        }
+    }
+    return pawnKeys;
+}
+
+inline constexpr PawnZobristKeys PawnZobristTable = BuildPawnZobristKeys();
+
+// The piece square scores are blended from midgame to endgame as totalMaterialValue goes from the
+// starting material down to a rook and a few pawns each.
+constexpr int32 OpeningMaterialValue = 2 * (QueenScore + (2 * RookScore) + (2 * BishopScore) +
+                                            (2 * KnightScore) + (8 * PawnScore));
+constexpr int32 EndgameMaterialValue = 2 * (RookScore + (4 * PawnScore));
+constexpr int32 MaxGamePhase         = 256;
+
+// This will be passed pawn pushes, promotions, castles, and maybe some other stuff.  Worst case is
+// 8 pawns that can each promote 4 ways on 3 squares, plus both castles.
+constexpr uint32 MaxNumProbablyGoodMoves = (8 * 3 * 4) + 2;
 enum MoveTypes : uint32
 {
     Best             = 0,
@@ -104,6 +175,8 @@ enum class Turn : uint32
 
 static constexpr uint64 WhiteKingStart           = 0x0000000000000010ull;
 static constexpr uint64 BlackKingStart           = 0x1000000000000000ull;
+static constexpr uint8  WhiteKingStartIdx        = 4;   // e1
+static constexpr uint8  BlackKingStartIdx        = 60;  // e8
 
 static constexpr uint64 WhiteKingSideCastleLand  = 0x0000000000000040ull;
 static constexpr uint64 WhiteQueenSideCastleLand = 0x0000000000000004ull;
@@ -141,27 +214,83 @@ enum MoveFlags : uint32
                        QueenPromotion,
 };
 
+// The square the king lands on for each castle, which is what a castle's toIdx is set to.
+static constexpr uint8 GetCastleKingLandIdx(uint32 castleFlag)
+{
+    return (castleFlag == WhiteKingCastle)  ? 6  :     // g1
+           (castleFlag == WhiteQueenCastle) ? 2  :     // c1
+           (castleFlag == BlackKingCastle)  ? 62 :     // g8
+                                              58;      // c8
+}
+
+// 8 bytes, so a ply's move lists and the killer and countermove tables take a quarter of the
+// cache the old bitboard version did.  Squares are 0-63 indexes, and the bitboards are built
+// when they're needed.  No real move starts and ends on the same square, so a zeroed Move is the
+// null move.
 struct Move
 {
-    uint64 fromPos;
-    uint64 toPos;
+    uint8  fromIdx;
+    uint8  toIdx;
     Piece  fromPiece;
     Piece  toPiece;
-    uint32 flags;
-    int32  score;
+    uint16 flags;
+    int16  score;
+
+    uint64 FromPos() const { return 1ull << fromIdx; }
+    uint64 ToPos()   const { return 1ull << toIdx;   }
+    bool   IsNull()  const { return fromIdx == toIdx; }
 };
 
-struct BoardInfo
+static_assert(sizeof(Move) == 8);
+
+constexpr uint8 NoSquare = 64;
+
+// The part of the board state a search node saves and puts back, kept to one cache line.  MakeMove
+// pushes it onto the undo stack whole and UnmakeMove copies it back; the pieces and mailbox are
+// worked back from the move instead.
+struct alignas(64) BoardInfo
 {
     uint64 blackPieces;
     uint64 whitePieces;
-    uint64 allPieces;
-    uint32 castleMask;
+
+    // Hash of the board into the transposition table.
+    uint64 zobristKey;
+
+    // Hash of just the pawns into the pawn hash table, from PawnZobristTable.
+    uint64 pawnKey;
 
     uint64 enPassantSquare;
 
-    bool isWhiteTurn;
+    // Also the move UnmakeMove is taking back, since everything made after it has been unmade.
+    Move   previousMove;
+
+    // Material can't go past 9 queens a side, so these all fit in 16 bits.
+    int16  pieceValueScore;      // whiteMaterial - blackMaterial
+    int16  totalMaterialValue;
 
+    // Sums of PieceSquareTable over the pieces on the board, white - black.
+    int16  midgamePieceSquareScore;
+    int16  endgamePieceSquareScore;
+
+    uint16 lastIrreversableMoveNum;
+    uint16 currMoveNum;
+
+    uint8  castleMask;
+
+    // Square of the last capture of a non-pawn, NoSquare if the last move wasn't one.
+    uint8  lastCaptureIdx;
+
+    bool   isWhiteTurn;
+};
+
+static_assert(sizeof(BoardInfo) == 64);
+
+// Check, pin and king move masks for the side to move.  They're derived from the pieces, so they
+// are never saved or copied: each ply has its own entry, a new ply starts with them invalid and
+// fills them in when move generation first asks, and unmaking back to a ply finds its entry as it
+// was left.
+struct MoveGenMasks
+{
     // Squares that are legal to move to to get out of check.  If we are not in check, this is a
     // mask of the whole board.
     uint64 checkMask;
@@ -190,29 +319,62 @@ struct BoardInfo
 
     uint32 legalCastles;
 
-    // Hash of the board into the transposition table.
-    uint64 zobristKey;
-
     bool checkAndPinMasksValid;
 
     bool illegalKingMovesValid;
+};
 
-    int32 pieceValueScore;      // whiteMaterial - blackMaterial
+// The squares each side attacks, pins and checks ignored.  Move generation needs the other side's
+// to keep the king out of check and to check castles, and ScoreBoard needs both sides' for king
+// safety and mobility, often at the same node.  So each side's are worked out the first time
+// move generation asks and kept for the rest of the ply, the same way as the MoveGenMasks.
+// ScoreBoard only reads them: it works out any side that isn't there yet into its own copy.  The
+// arrays are indexed by the attacking side, see GetAttackSide.
+struct AttackInfo
+{
+    // Squares attacked by each of Board's pieces, white's by wKing..wPawn and black's by
+    // bKing..bPawn.
+    uint64 pieceAttacks[Piece::NoPiece];
 
-    uint64 lastPosMoved;
-    uint64 lastPosCaptured;
+    uint64 attacks[2];
 
-    uint8 numPieceArr[Piece::PieceCount];
-    int32 totalMaterialValue;
+    // Squares attacked by more than one piece.  Both of a pawn's captures count once each.
+    uint64 attackedTwice[2];
 
-    uint32 lastIrreversableMoveNum;
+    // Squares next to the other side's king that this side attacks.
+    uint64 kingZoneAttacks[2];
 
-    uint32 currMoveNum;
+    bool   valid[2];
+};
 
-    Move previousMove;
+constexpr uint32 GetAttackSide(bool isWhite) { return (isWhite) ? 0 : 1; }
+
+// true makes MakeMove push a copy of the whole board and UnmakeMove copy it back, the way every
+// search node used to.  Only here so the two can be benchmarked against each other.
+constexpr bool BoardCopyMake = false;
+
+// Same limit as the repetition table, which is also indexed by moves from the FEN.
+constexpr uint32 MaxUndoStackSize = 1024;
+constexpr uint32 PrevZobKeyVecLength = 1024;
+
+struct CopyMakeUndoInfo
+{
+    BoardInfo boardState;
+    uint64    pieces[Piece::PieceCount];
+    Piece     mailbox[64];
+    uint8     numPieceArr[Piece::PieceCount];
 };
 
-constexpr uint32 boardInfosize = sizeof(BoardInfo);
+using UndoEntry = std::conditional_t<BoardCopyMake, CopyMakeUndoInfo, BoardInfo>;
+
+// A position without any of the per-ply stacks, for keeping a game's history.  The repetition keys
+// are the ones IsDrawByRepetition can still look back at, so a restored board finds the same
+// repetitions.
+struct BoardSnapshot
+{
+    CopyMakeUndoInfo    position;
+    std::vector<uint64> repetitionKeys;
+};
 
 class Board
 {
@@ -220,6 +382,11 @@ public:
     Board();
     ~Board();
 
+    // The per-ply stacks are sized for MaxUndoStackSize plies, hundreds of KB, so a copy only
+    // carries the plies in use, [0, m_undoStackSize].
+    Board(const Board& other);
+    Board& operator=(const Board& other);
+
     Result Init();
     Result Destroy();
 
@@ -227,6 +394,7 @@ public:
     void ResetBoard();
 
     Piece GetPieceFromPos(uint64 pos);
+    Piece GetPieceFromIdx(uint32 idx) { return m_mailbox[idx]; }
 
     template<bool isWhite>
     void MakeMove(const Move& move);
@@ -234,10 +402,23 @@ public:
     template<bool isWhite>
     void MakeNullMove();
 
-    void UndoMove(BoardInfo* pBoardInfo, uint64* pPieceData);
+    // Takes back the last MakeMove, which has to have been made for isWhite.
+    template<bool isWhite>
+    void UnmakeMove();
+
+    void UnmakeNullMove();
 
+    // True if everything the make functions keep up agrees with a recount from the pieces.
     bool VerifyBoard();
 
+    void SaveSnapshot(BoardSnapshot* pSnapshot) const;
+
+    // Puts the board back to the snapshot's position with an empty undo stack.
+    void RestoreSnapshot(const BoardSnapshot& snapshot);
+
+    // Same pieces, side to move, castling, en passant square, and move number.
+    bool IsSamePosition(const BoardSnapshot& snapshot) const;
+
     uint64 GetEnPassantPos() { return m_boardState.enPassantSquare; }
 
     template<bool isWhite>
@@ -251,8 +432,10 @@ public:
     template<bool isWhite, bool onlyCaptures>
     void GenerateLegalMoves(Move** ppMoveList, uint32* pNumMoves = nullptr);
 
-    void CopyBoardData(BoardInfo* pBoardInfo) { memcpy(pBoardInfo, &m_boardState, sizeof(BoardInfo)); }
-    void CopyPieceData(uint64* pPieceData) { memcpy(pPieceData, &(m_pieces[0]), sizeof(m_pieces)); }
+    // Number of legal moves GenerateLegalMoves<isWhite, false> would generate, without writing any
+    // of them out.  Each piece's legal targets are popcounted, promotions count 4 times.
+    template<bool isWhite>
+    uint32 CountLegalMoves();
 
     template<Piece piece, bool isWhite>
     inline uint64 GetPieces()
@@ -267,22 +450,22 @@ public:
     }
 
     template<bool isWhite>
-    inline uint64 GetKing()   { if constexpr (isWhite) return WKing();   else return BKing();   }
+    inline uint64 GetKing()   const { if constexpr (isWhite) return WKing();   else return BKing();   }
     template<bool isWhite>
-    inline uint64 GetQueen()  { if constexpr (isWhite) return WQueen();  else return BQueen();  }
+    inline uint64 GetQueen()  const { if constexpr (isWhite) return WQueen();  else return BQueen();  }
     template<bool isWhite>
-    inline uint64 GetRook()   { if constexpr (isWhite) return WRook();   else return BRook();   }
+    inline uint64 GetRook()   const { if constexpr (isWhite) return WRook();   else return BRook();   }
     template<bool isWhite>
-    inline uint64 GetBishop() { if constexpr (isWhite) return WBishop(); else return BBishop(); }
+    inline uint64 GetBishop() const { if constexpr (isWhite) return WBishop(); else return BBishop(); }
     template<bool isWhite>
-    inline uint64 GetKnight() { if constexpr (isWhite) return WKnight(); else return BKnight(); }
+    inline uint64 GetKnight() const { if constexpr (isWhite) return WKnight(); else return BKnight(); }
     template<bool isWhite>
-    inline uint64 GetPawn()   { if constexpr (isWhite) return WPawn();   else return BPawn();   }
+    inline uint64 GetPawn()   const { if constexpr (isWhite) return WPawn();   else return BPawn();   }
 
-    uint64 GetAllPieces() { return m_boardState.allPieces; }
+    uint64 GetAllPieces() const { return m_boardState.whitePieces | m_boardState.blackPieces; }
 
-    uint64 GetBlackPieces() { return m_boardState.blackPieces; }
-    uint64 GetWhitePieces() { return m_boardState.whitePieces; }
+    uint64 GetBlackPieces() const { return m_boardState.blackPieces; }
+    uint64 GetWhitePieces() const { return m_boardState.whitePieces; }
 
     // Function to be used for printing legal moves for a square... Shouldn't use in the engine.
     uint64 GetLegalMoves(uint64 pos);
@@ -291,21 +474,50 @@ public:
 
     void SetBoardFromFEN(std::string fen);
 
+    // Doesn't change the board, so it can be called from anywhere in the search without disturbing
+    // the move generation masks or the attack maps.  It does fill in the pawn hash table though,
+    // so it's only safe from more than one thread if each thread has its own table.
+    template<bool isWhite>
+    int32 ScoreBoard() const;
+
+    // Lazy version for the search.  If the cheap terms put the score more than lazyMargin outside
+    // [alpha, beta), it returns them without building the attack maps and sets *pLazyExit, and
+    // the score is only good as a bound.
     template<bool isWhite>
-    int32 ScoreBoard();
+    int32 ScoreBoard(int32 alpha, int32 beta, int32 lazyMargin, bool* pLazyExit) const;
+
+    // Fills in isWhite's attacks in this ply's AttackInfo if they aren't already.  The other
+    // side's are only there if something already asked for them.
+    template<bool isWhite>
+    const AttackInfo& GetAttackInfo();
 
     // Assumes the checkmask has been set already.
-    bool InCheck() { return m_boardState.numPiecesChecking != 0; }
+    bool InCheck() { return GetMasks().numPiecesChecking != 0; }
 
     template<bool isWhite, bool printReason = false>
     bool IsMoveLegal(const Move& move);
 
     uint64 GetZobKey() { return m_boardState.zobristKey; }
 
-    void InvalidateCheckPinAndIllegalMoves() { m_boardState.illegalKingMovesValid = false;
-                                               m_boardState.checkAndPinMasksValid = false;}
+    // ScoreBoard caches the pawn terms here, without any locking.  Each search thread points its
+    // own board at its own table, and a board with none set works the pawn terms out every time.
+    void SetPawnHashTable(PawnHashTable* pPawnHashTable) { m_pPawnHashTable = pPawnHashTable; }
+
+    // Once a network is set, the make functions keep an NnueAccumulator per ply for it and
+    // EvaluateNnue can be used in place of ScoreBoard.  nullptr stops the updates and frees them.
+    void SetNnueNetwork(const NnueNetwork* pNetwork);
+
+    bool UsesNnue() const { return m_pNnueNetwork != nullptr; }
 
-    uint64 GetLastPosCaptured() { return m_boardState.lastPosCaptured; }
+    // Centipawns for isWhite, which has to be the side to move.
+    template<bool isWhite>
+    int32 EvaluateNnue();
+
+    void InvalidateCheckPinAndIllegalMoves() { GetMasks().illegalKingMovesValid = false;
+                                               GetMasks().checkAndPinMasksValid = false;}
+
+    uint64 GetLastPosCaptured() { return (m_boardState.lastCaptureIdx == NoSquare) ? 0ull :
+                                         (1ull << m_boardState.lastCaptureIdx); }
 
     bool GetBoardStateIsWhiteTurn() { return m_boardState.isWhiteTurn; }
 
@@ -322,6 +534,40 @@ private:
 
     void ResetPieceScore();
 
+    void ResetMailbox();
+
+    void ResetPawnKey();
+
+    void PushUndoEntry();
+    void SaveUndoEntry(BoardInfo* pUndo) const;
+    void SaveUndoEntry(CopyMakeUndoInfo* pUndo) const;
+    void RestoreUndoEntry(const BoardInfo& undo);
+    void RestoreUndoEntry(const CopyMakeUndoInfo& undo);
+
+    MoveGenMasks& GetMasks() { return m_moveGenMasks[m_undoStackSize]; }
+
+    void InvalidateAttackInfo() { m_attackInfo[m_undoStackSize].valid[0] = false;
+                                  m_attackInfo[m_undoStackSize].valid[1] = false; }
+
+    template<bool isWhite, SliderBackend backend>
+    void GenerateAttackInfo(AttackInfo* pAttackInfo) const;
+
+    // Generates isWhite's side of *pAttackInfo if it isn't valid yet.
+    template<bool isWhite>
+    void FillAttackInfo(AttackInfo* pAttackInfo) const;
+
+    NnueAccumulator& GetNnueAccumulator() { return m_nnueAccumulators[m_undoStackSize]; }
+
+    void RefreshNnueAccumulator();
+
+    // Works this ply's accumulator out from the last ply's.
+    template<bool isWhite>
+    void UpdateNnueAccumulator(const Move& move);
+    void ApplyNnueDelta(const NnueDelta& delta);
+
+    template<bool isWhite>
+    void UnmakePieces(const Move& move);
+
     template<bool isWhite>
     void MakeNormalMove(const Move& move);
 
@@ -340,19 +586,37 @@ private:
     template<bool IsWhite>
     void UpdateCastleFlags(const Move& move);
 
-    inline  uint64 WKing()   { return m_pieces[Piece::wKing];   }
-    inline  uint64 WQueen()  { return m_pieces[Piece::wQueen];  }
-    inline  uint64 WRook()   { return m_pieces[Piece::wRook];   }
-    inline  uint64 WBishop() { return m_pieces[Piece::wBishop]; }
-    inline  uint64 WKnight() { return m_pieces[Piece::wKnight]; }
-    inline  uint64 WPawn()   { return m_pieces[Piece::wPawn];   }
+    void AddPieceSquareScore(Piece piece, uint32 idx)
+    {
+        m_boardState.midgamePieceSquareScore += PieceSquareTable.midgame[piece][idx];
+        m_boardState.endgamePieceSquareScore += PieceSquareTable.endgame[piece][idx];
+    }
 
-    inline  uint64 BKing()   { return m_pieces[Piece::bKing];   }
-    inline  uint64 BQueen()  { return m_pieces[Piece::bQueen];  }
-    inline  uint64 BRook()   { return m_pieces[Piece::bRook];   }
-    inline  uint64 BBishop() { return m_pieces[Piece::bBishop]; }
-    inline  uint64 BKnight() { return m_pieces[Piece::bKnight]; }
-    inline  uint64 BPawn()   { return m_pieces[Piece::bPawn];   }
+    void RemovePieceSquareScore(Piece piece, uint32 idx)
+    {
+        m_boardState.midgamePieceSquareScore -= PieceSquareTable.midgame[piece][idx];
+        m_boardState.endgamePieceSquareScore -= PieceSquareTable.endgame[piece][idx];
+    }
+
+    void MovePieceSquareScore(Piece piece, uint32 fromIdx, uint32 toIdx)
+    {
+        RemovePieceSquareScore(piece, fromIdx);
+        AddPieceSquareScore(piece, toIdx);
+    }
+
+    inline  uint64 WKing()   const { return m_pieces[Piece::wKing];   }
+    inline  uint64 WQueen()  const { return m_pieces[Piece::wQueen];  }
+    inline  uint64 WRook()   const { return m_pieces[Piece::wRook];   }
+    inline  uint64 WBishop() const { return m_pieces[Piece::wBishop]; }
+    inline  uint64 WKnight() const { return m_pieces[Piece::wKnight]; }
+    inline  uint64 WPawn()   const { return m_pieces[Piece::wPawn];   }
+
+    inline  uint64 BKing()   const { return m_pieces[Piece::bKing];   }
+    inline  uint64 BQueen()  const { return m_pieces[Piece::bQueen];  }
+    inline  uint64 BRook()   const { return m_pieces[Piece::bRook];   }
+    inline  uint64 BBishop() const { return m_pieces[Piece::bBishop]; }
+    inline  uint64 BKnight() const { return m_pieces[Piece::bKnight]; }
+    inline  uint64 BPawn()   const { return m_pieces[Piece::bPawn];   }
 
     inline  bool IsWhiteKing  (uint64 piece) { return (piece & WKing())   != 0; }
     inline  bool IsWhiteQueen (uint64 piece) { return (piece & WQueen())  != 0; }
@@ -371,25 +635,46 @@ private:
     inline  bool IsBlack(uint64 piece) { return (m_boardState.blackPieces & piece) != 0ull; }
     inline  bool IsWhite(uint64 piece) { return (m_boardState.whitePieces & piece) != 0ull; }
 
-    // templated for isWhite, you should know if the piece you're looking for is black or white...
-    template<bool isWhite> Piece GetPieceFromPos(uint64 pos);
-
     template<Directions dir>
-    uint64 CastRayToBlocker(uint64 pos, uint64 mask);
+    uint64 CastRayToBlocker(uint64 pos, uint64 mask) const;
+
+    // Slider attacks (ignoring legality) on the current board.  The move generation entry points
+    // switch on ActiveSliderBackend once and pass it down, so the lookups themselves don't branch.
+    template<SliderBackend backend>
+    uint64 GetRookAttacks(uint64 pos) const;
+    template<SliderBackend backend>
+    uint64 GetBishopAttacks(uint64 pos) const;
+
+    template<SliderBackend backend>
+    uint64 GetRookAttacksWithBackend(uint64 pos, uint64 occupied) const;
+
+    template<SliderBackend backend>
+    uint64 GetBishopAttacksWithBackend(uint64 pos, uint64 occupied) const;
+
+    template<SliderBackend backend>
+    uint64 TimeSliderBackend(uint64* pSink);
+
+    void SelectSliderBackend();
 
     template<Directions dir, bool isWhite>
     void GetCheckmaskAndPinsInDirection(uint64 pos);
 
     void GenerateRayTable();
 
-    template<Piece pieceType, bool isWhite, bool hasEnPassant, bool onlyCaptures>
-    void GeneratePieceMoves(Move** ppMoveList, uint32* pNumCapture, uint32* pNumNormal, uint32* pNumProbGood);
-
     template<bool isWhite>
-    uint64 GetPawnKnightKingSeenSquares();
+    uint32 CountPawnMoves();
 
-    template<bool isWhite>
-    uint64 GetSliderSeenSquares(uint64 curKingMoves);
+    template<Piece pieceType, bool isWhite, SliderBackend backend>
+    uint32 CountPieceMoves();
+
+    template<bool isWhite, bool onlyCaptures, SliderBackend backend>
+    void GenerateLegalMovesWithBackend(Move** ppMoveList, uint32* pNumMoves);
+
+    template<bool isWhite, SliderBackend backend>
+    uint32 CountLegalMovesWithBackend();
+
+    template<Piece pieceType, bool isWhite, bool hasEnPassant, bool onlyCaptures, SliderBackend backend>
+    void GeneratePieceMoves(Move** ppMoveList, uint32* pNumCapture, uint32* pNumNormal, uint32* pNumProbGood);
 
     void InitZobArray();
 
@@ -397,12 +682,18 @@ private:
 
     template<bool isWhite, bool hasEnPassant> uint64 GetPawnMoves      (uint64 pos);
     template<bool isWhite, bool ignoreLegal>  uint64 GetKnightMoves    (uint64 pos);
-    template<bool isWhite, bool ignoreLegal>  uint64 GetRookMoves      (uint64 pos);
-    template<bool isWhite, bool ignoreLegal>  uint64 GetBishopMoves    (uint64 pos);
-    template<bool isWhite, bool ignoreLegal>  uint64 GetQueenMoves     (uint64 pos);
     template<bool isWhite, bool ignoreLegal>  uint64 GetKingMoves      (uint64 pos);
 
-    template<Piece pieceType, bool isWhite, bool hasEnPassant> uint64 GetPieceMoves(uint64 pos);
+    template<bool isWhite, bool ignoreLegal, SliderBackend backend> uint64 GetRookMoves  (uint64 pos);
+    template<bool isWhite, bool ignoreLegal, SliderBackend backend> uint64 GetBishopMoves(uint64 pos);
+    template<bool isWhite, bool ignoreLegal, SliderBackend backend> uint64 GetQueenMoves (uint64 pos);
+
+    template<Piece pieceType, bool isWhite, bool hasEnPassant, SliderBackend backend>
+    uint64 GetPieceMoves(uint64 pos);
+
+    // One slider's legal moves with whichever backend is active.
+    template<Piece pieceType, bool isWhite>
+    uint64 GetSliderMoves(uint64 pos);
 
     template<bool isWhite>
     void UpdateLastIrreversableMove(const Move& move);
@@ -414,21 +705,50 @@ private:
         uint64 enemyPawn = GetPawn<isWhite>();
     }
 
-    int32 GetKingSafteyScore(uint64 whiteSeenSquares, uint64 blackSeenSquares);
-    int32 GetPawnBonusScores();
-    int32 GetRookBonusScores();
-    int32 GetKnightBonusScores();
-    int32 AggressiveKingEndgameBonus();
+    int32 GetPieceSquareScore() const;
+    int32 GetKingSafteyScore(const AttackInfo& attackInfo) const;
+    int32 GetPawnBonusScores() const;
+    void  EvaluatePawnStructure(PawnHashEntry* pEntry) const;
+    int32 GetRookBonusScores() const;
+    int32 GetKnightBonusScores() const;
+    int32 AggressiveKingEndgameBonus() const;
 
     uint64 m_pieces[static_cast<uint32>(Piece::PieceCount)];
+
+    // The piece on each square, NoPiece when empty.  The Make*Move functions keep it in sync with
+    // m_pieces so a capture or promotion finds the piece it lands on with one load.
+    Piece  m_mailbox[64];
     uint64 m_pRayTable[Directions::Count][64];
 
     std::vector<uint64> m_prevZobKeyVec;
 
+    // One entry per MakeMove/MakeNullMove since the last SetBoardFromFEN.
+    std::vector<UndoEntry> m_undoStack;
+    uint32                 m_undoStackSize;
+
+    // Indexed by m_undoStackSize, so the current ply's masks are GetMasks().
+    std::vector<MoveGenMasks> m_moveGenMasks;
+
+    // Indexed by m_undoStackSize like the masks.
+    std::vector<AttackInfo> m_attackInfo;
+
+    // Indexed by m_undoStackSize like the masks, and only allocated while a network is set.
+    // Unmaking just goes back to the ply below's accumulator, which is still there.  Only the plies
+    // from m_nnueValidPly up are known to be for the board: anything below it was left from before
+    // the last refresh, so going back under it means refreshing again.
+    const NnueNetwork*           m_pNnueNetwork;
+    std::vector<NnueAccumulator> m_nnueAccumulators;
+    uint32                       m_nnueValidPly;
+
+    // Changes with captures only, so UnmakeMove puts it back rather than saving it every ply.
+    uint8  m_numPieceArr[Piece::PieceCount];
+
     // the reason it isn't 64 is bc there needs to be extra spaces for ep, castling, and 
     uint64** m_ppZobristArray;
 
     BoardInfo m_boardState;
 
+    PawnHashTable* m_pPawnHashTable;
+
     bool m_fancyPrint;
 };
\ No newline at end of file
@@ -5,9 +5,17 @@
 #include "engine.h"
 #include <map>
 #include <vector>
+#include <atomic>
+#include <thread>
 
 static constexpr uint32 MaxCommandLength = 512;
 static constexpr uint32 MaxFenStrLength = 128;
+static constexpr uint32 MaxFileNameLength = 256;
+
+static constexpr uint32 UciMaxHashMB        = 65536;
+static constexpr uint32 UciMaxEvalHashKB    = 1048576;
+static constexpr uint32 UciDefaultMovesToGo = 30;   // Time is split as if this many moves are left
+static constexpr uint32 UciMoveOverheadMs   = 10;   // Kept back per move for the GUI's lag
 
 enum class Commands : uint32
 {
@@ -21,6 +29,16 @@ enum class Commands : uint32
     Engine,
     Compare,
     Score,
+    TTStress,
+    TTBench,
+    MakeBench,
+    Hash,
+    EvalHash,
+    Uci,
+    PerftSuite,
+    Evaluator,
+    EvalFile,
+    Numa,
 
     NumCommands,
     Error,
@@ -28,6 +46,8 @@ enum class Commands : uint32
 
 typedef std::map<std::string, Commands> CommandMap;
 
+bool IsInteger(std::string str);
+
 struct InputCommand
 {
     Commands command;
@@ -52,11 +72,15 @@ struct InputCommand
             bool isWhite;
             uint32 depth;
             bool expanded;
+            uint32 numThreads;
+            bool reportSpeedup;     // Run single threaded first and compare
+            bool useHash;
         } perft;
 
         struct
         {
             EngineSettings settings;
+            bool           reportSpeedup;   // Run once single threaded first and compare
         } engine;
 
         struct
@@ -69,7 +93,42 @@ struct InputCommand
         {
             EngineSettings whiteEngine;
             EngineSettings blackEngine;
+            bool           sharedTT;    // Both sides search with m_engine and its table
         } compare;
+
+        struct
+        {
+            uint32 numThreads;
+            uint32 numWalks;
+        } ttStress;
+
+        struct
+        {
+            uint32 size;            // MB for hash, KB for evalhash
+        } hash;
+
+        struct
+        {
+            bool interleave;
+        } numa;
+
+        struct
+        {
+            char   fileName[MaxFileNameLength];
+            uint32 maxDepth;        // Deepest expected count at or below this is checked
+            uint32 numThreads;
+            bool   useHash;
+        } perftSuite;
+
+        struct
+        {
+            bool useNnue;
+        } evaluator;
+
+        struct
+        {
+            char fileName[MaxFileNameLength];
+        } evalFile;
     };
 };
 
@@ -84,12 +143,18 @@ public:
 
     void Run();
 
+    // Runs one command given on the command line instead of the interactive loop, for scripts and
+    // CI.  Returns the process exit code.
+    int32 RunCommandLine(int32 argc, char** argv);
+
 private:
     Result HandleInput();
     InputCommand ParseInput(std::string input);
     void GenerateCommandMap();
 
-    void DoCompareEngines(EngineSettings engine1, EngineSettings engine2);
+    void DoCompareEngines(EngineSettings engine1, EngineSettings engine2, bool sharedTT);
+
+    void DoSmpSpeedup(EngineSettings settings);
 
     Result ParseMoveCommand(
         std::vector<std::string> commandVec,
@@ -121,8 +186,84 @@ private:
         InputCommand* pInputCommand
     );
 
+    Result ParseTTStressCommand(
+        std::vector<std::string> commandVec,
+        InputCommand* pInputCommand
+    );
+
+    Result ParseHashCommand(
+        std::vector<std::string> commandVec,
+        InputCommand* pInputCommand
+    );
+
+    Result ParsePerftSuiteCommand(
+        std::vector<std::string> commandVec,
+        const std::string&       caseStr,
+        InputCommand* pInputCommand
+    );
+
+    Result ParseEvaluatorCommand(
+        std::vector<std::string> commandVec,
+        InputCommand* pInputCommand
+    );
+
+    Result ParseNumaCommand(
+        std::vector<std::string> commandVec,
+        InputCommand* pInputCommand
+    );
+
+    Result ParseEvalFileCommand(
+        std::vector<std::string> commandVec,
+        const std::string&       caseStr,
+        InputCommand* pInputCommand
+    );
+
+    // Loads pFileName into m_pNnueNetwork.  The network that was loaded is lost either way, so if
+    // the file doesn't load the board goes back to ScoreBoard.
+    bool LoadNnueFile(const char* pFileName);
+
+    // Points the board at the network if it's loaded and m_useNnue is set, otherwise at no network.
+    // Clears the eval caches, since their scores are for the evaluator that was being used.
+    void SelectEvaluator();
+
+    // Reallocates the transposition tables with m_transTableSizeMB and m_interleaveNuma.  If the
+    // size couldn't be allocated, returns false and sets m_transTableSizeMB to what was.
+    bool ReallocTransTables();
+
+    // Perft suite, in chess_perftSuite.cpp.  Returns Result::Success if every position's count
+    // matched, Result::Error if any didn't or a line was malformed, and Result::ErrorInvalidInput
+    // if the file couldn't be read or had no counts at maxDepth or below.
+    Result DoPerftSuite(const char* pFileName, uint32 maxDepth, uint32 numThreads, bool useHash);
+
+    // UCI mode, in chess_uci.cpp.  Takes over from Run once the GUI sends "uci".
+    void RunUci();
+    void UciPosition(const std::vector<std::string>& wordVec);
+    void UciGo(const std::vector<std::string>& wordVec);
+    void UciSetOption(const std::vector<std::string>& wordVec);
+    void UciStopSearch();
+
     CommandMap         m_commandMap;
     Board              m_board;
-    std::vector<Board> m_historyVec;
+    std::vector<BoardSnapshot> m_historyVec;
     ChessEngine        m_engine;
+
+    // Plays black in compare mode, so each side has its own transposition table.  Only
+    // initialized the first time it's needed, since it's a whole second table.
+    ChessEngine        m_compareEngine;
+    bool               m_compareEngineInit;
+    uint32             m_transTableSizeMB;
+    uint32             m_evalCacheSizeKB;
+    bool               m_interleaveNuma;
+
+    // Loaded from DefaultNnueFileName at startup and used whenever it loaded, unless the
+    // evaluator is switched back to ScoreBoard.  Large, so it's on the heap.
+    NnueNetwork*       m_pNnueNetwork;
+    bool               m_useNnue;
+
+    // UCI searches run on their own thread so "stop" and "isready" are answered right away.
+    // m_uciStop is the isTimedOut flag the search is given.
+    std::thread        m_uciSearchThread;
+    std::atomic<bool>  m_uciStop;
+    std::atomic<bool>  m_uciSearchDone;
+    uint32             m_uciNumThreads;
 };
\ No newline at end of file
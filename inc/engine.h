@@ -3,8 +3,13 @@
 #include "../inc/board.h"
 #include "../inc/util.h"
 #include "../inc/transTable.h"
+#include "../inc/perftTable.h"
+#include "../inc/pawnHashTable.h"
+#include "../inc/evalCache.h"
 #include <chrono>
 #include <atomic>
+#include <thread>
+#include <vector>
 
 // Most Valuble Victim Least Valuble Attacker Array.
 // Array indexed by [attacker][attackee] (attacker is the row, attacked is the column). So for 
@@ -28,8 +33,8 @@ constexpr int32 InitialBeta       =  0x7FFF;
 constexpr int32 InvalidScore           = -0x5FFF;
 constexpr int32 TTScoreNotFound        = -0x5FF0;
 
-constexpr uint32 MainTransTableSize    = 8000009; //15485867;  // large-ish prime
-constexpr uint32 QSearchTransTableSize =  999983; // 999983;
+constexpr uint32 DefaultTransTableSizeMB = 256;
+constexpr bool   DefaultInterleaveTransTables = true;   // Spread the table over all the NUMA nodes
 
 constexpr int32 CastleScore = 150;
 
@@ -38,6 +43,18 @@ constexpr uint32 NumKillerMoves = 2;
 
 constexpr int32 NotCheckMate = -999;
 
+// Lazy SMP thread limit, including the main search thread.
+constexpr uint32 MaxSearchThreads = 64;
+
+// Parallel perft splits the tree into tasks a few plies down, deep enough that there are at least
+// PerftTasksPerThread tasks for every thread so one big subtree can't leave the others idle.
+constexpr uint32 MaxPerftSplitPly    = 3;
+constexpr uint32 PerftTasksPerThread = 8;
+
+// Count perft's leaves with Board::CountLegalMoves instead of generating them.  Only there to A/B
+// against the move lists.
+constexpr bool PerftBulkCount = true;
+
 struct GetNextMoveData
 {
     uint32    moveIdx;
@@ -46,6 +63,13 @@ struct GetNextMoveData
     bool      sortedProbGood;
 };
 
+// The moves from the perft root down to the subtree one parallel perft worker counts.
+struct PerftTask
+{
+    Move   moves[MaxPerftSplitPly];
+    uint32 numMoves;
+};
+
 struct SearchSettings
 {
     bool   onPv;                    //> Principle Variation doesn't have any pruning
@@ -99,6 +123,9 @@ struct SearchSettings
     bool  doNullMoveReduction;      //> This is different than null move pruning.  What this does
     int32 nullReductionDepth;       //  is decrease the rest of the search depth if a very reduced
     int32 nullReductionSearchDepth; //  depth null move search leads to a beta cutoff.
+
+    bool  lazyEval;                 //> Skip king safety and mobility when the rest of the eval is
+    int32 lazyEvalMargin;           //  more than lazyEvalMargin outside the window it's needed in
 };
 
 typedef std::chrono::milliseconds TimeType;
@@ -110,6 +137,10 @@ struct EngineSettings
     bool           isWhite;
     bool           doMove;
     bool           printStats;
+    uint32         numThreads;      // Lazy SMP threads including the main one.  0 and 1 are the
+                                    // same as single threaded.
+    uint64         maxNodes;        // Stop once the main thread searches this many, 0 for no limit
+    bool           printUciInfo;    // UCI "info" line after every finished depth
     SearchSettings searchSettings;
 };
 
@@ -127,7 +158,18 @@ public:
                   uint32*            pMaxDepth = nullptr,
                   bool*              pIsMoveLegal = nullptr);
 
-    void DoPerft(uint32 depth, bool isWhite, bool expanded);
+    // numThreads > 1 runs the parallel perft.  reportSpeedup runs it single threaded first and
+    // checks the node counts match.  useHash skips subtrees already counted through another move
+    // order, every run starts from an empty perft table.
+    void DoPerft(uint32 depth,
+                 bool   isWhite,
+                 bool   expanded,
+                 uint32 numThreads    = 1,
+                 bool   reportSpeedup = false,
+                 bool   useHash       = false);
+
+    // Leaf count for the side to move, for the perft suite.
+    uint64 CountPerft(uint32 depth, uint32 numThreads, bool useHash);
 
     template<bool isWhite>
     uint32 Perft(uint32 depth, uint32 ply);
@@ -155,14 +197,77 @@ public:
                           int32              maxFreePly,
                           uint64             movedPieces=0ull);
 
-    void ResetTransTable() { m_engineMainTTs[0].ResetTable(); m_engineMainTTs[1].ResetTable();
-                          m_engineQSearchTTs[0].ResetTable(); m_engineQSearchTTs[1].ResetTable(); }
+    void ResetTransTable() { m_pTransTable->ResetTable(); }
+
+    // Reallocates the transposition table, which also clears it.  Returns false if it couldn't be
+    // made that big, GetTransTableSizeMB is the size it ended up.
+    bool   SetTransTableSizeMB(uint32 sizeMB) { return m_transTable.SetSizeMB(sizeMB); }
+    uint32 GetTransTableSizeMB() { return m_transTable.GetSizeMB(); }
+
+    // Same, but also sets whether the table's pages are interleaved over the NUMA nodes.
+    bool InitTransTable(uint32 sizeMB, bool interleaveNuma)
+    {
+        return m_transTable.Init(sizeMB, interleaveNuma);
+    }
+
+    void PrintTransTableMemory();
+
+    // Same for the eval cache, which is sized on its own.
+    void SetEvalCacheSizeKB(uint32 sizeKB) { m_evalCache.SetSizeKB(sizeKB); }
+
+    // The cached scores are only good for the evaluator that made them.
+    void ResetEvalCache() { m_evalCache.ResetCache(); }
 
     std::string ConvertScoreToStr(int32 score, int32* pCheckMateDepth = nullptr);
 
     void ResetKillers();
 
+    // Positions searched by the last DoEngine call, summed over all the search threads.
+    uint64 GetPositionsSearched();
+
+    // Random walks from the current position on numThreads threads, all probing and filling one
+    // small transposition table.  Every probe that matches a key has to give back a move and score
+    // that were inserted for that key, otherwise an entry got torn.  Returns true if none were.
+    bool DoTTStressTest(uint32 numThreads, uint32 numWalks);
+
+    // Probe latency on the main table and on a table small enough to stay in cache.
+    void DoTTBenchmark();
+
+    // Time to make and unmake each legal move from the current position, and the size of what the
+    // board saves per ply.
+    void DoMakeMoveBenchmark();
+
+    // Finds the legal move for the side to move that prints as moveStr (e2e4, e7e8q, e1g1).
+    bool GetMoveFromString(const std::string& moveStr, Move* pMove);
+
 private:
+    void InitMoveLists();
+    void DestroyMoveLists();
+
+    void InitHelper(uint32 threadIdx);
+    void CreateHelperEngines(uint32 numHelpers);
+
+    void UsePerftTable(bool useHash);
+
+    template<bool isWhite>
+    void RunPerft(uint32 depth, bool expanded);
+
+    template<bool isWhite>
+    void ParallelPerft(uint32 depth, uint32 numThreads, bool printStats);
+
+    template<bool isWhite>
+    void SplitPerftTasks(uint32                  splitPly,
+                         uint32                  ply,
+                         PerftTask*              pTask,
+                         std::vector<PerftTask>* pTasks);
+
+    void RunPerftTask(const Board& rootBoard, bool isWhite, uint32 depth, const PerftTask& task);
+
+    template<bool isWhite>
+    void StartHelperThreads(const EngineSettings&     settings,
+                            std::atomic<bool>&        stopHelpers,
+                            std::vector<std::thread>* pHelperThreads);
+
     template<bool isWhite>
     Move IterativeDeepening(
         uint32              depth, 
@@ -172,18 +277,68 @@ private:
         std::atomic<bool>&  isTimedOut,
         uint32*             pMaxDepth = nullptr);
 
+    // For a search stopped before it finished depth 1.  The move the partial search liked best
+    // if it got that far, otherwise the first legal move, and a null move only if there are none.
+    template<bool isWhite>
+    Move GetFallbackMove(const Move& partialBestMove);
+
+    template<bool isWhite>
+    void PrintUciInfo(uint32 depth, const Move& bestMove, TimeType elapsedTime);
+
+    template<bool isWhite>
+    void AppendPvMove(const Move& move, uint32 pvLength, std::string* pPvStr);
+
+    template<bool isWhite>
+    void TTStressTestWalk(TranspositionTable* pTable,
+                          uint32              ply,
+                          uint32              maxPly,
+                          uint64*             pRandState,
+                          uint64*             pNumHits,
+                          uint64*             pNumBadHits);
+
+    template<bool isWhite>
+    uint64 TimeMakeUnmake(const Move* pMoves, uint32 numMoves, uint32 numPasses, uint64* pSink);
+
+    // ScoreBoard<isWhite>, or EvaluateNnue<isWhite> if the board has a network, through the eval
+    // cache.  Only a ScoreBoard score inside [alpha, beta) has to be exact, see
+    // SearchSettings::lazyEval.
+    template<bool isWhite>
+    int32 EvaluateBoard(int32 alpha, int32 beta, const SearchSettings& settings);
+
     void InsertKillerMove(const Move& move, uint32 ply);
     void InsertCounterMove(const Move& move);
 
-    TranspositionTable m_engineMainTTs[2];
-    TranspositionTable m_engineQSearchTTs[2];
-
-    TranspositionTable* m_pMainSearchTransTable;
-    TranspositionTable* m_pQSearchTransTable;
+    // One table for both colours and for main and qsearch.  Each ChessEngine owns its own, so two
+    // engines playing each other don't see each other's entries.
+    TranspositionTable  m_transTable;
+    TranspositionTable* m_pTransTable;
 
     Board*  m_pBoard;
     Move*** m_pppMoveLists;
 
+    // Subtree counts for hashed perft.  m_pPerftTable is null when perft isn't hashing, helpers
+    // point it at the main engine's table.
+    PerftTable  m_perftTable;
+    PerftTable* m_pPerftTable;
+
+    // Static evals, shared by the helpers the same way as the transposition table.
+    EvalCache  m_evalCache;
+    EvalCache* m_pEvalCache;
+
+    // Pawn terms for ScoreBoard.  Every engine has its own, helpers included, so no two search
+    // threads ever share one.
+    PawnHashTable m_pawnHashTable;
+
+    // Lazy SMP helpers.  Each one searches its own copy of the board with its own move lists,
+    // killers, and countermoves, but probes and fills this engine's transposition table.
+    std::vector<ChessEngine*> m_helperEngines;
+    Board                     m_helperBoard;    // Only used if this engine is a helper
+    uint32                    m_threadIdx;      // 0 for the main search thread
+
+    // Only ever set on the main search thread's engine, for the search DoEngine is running.
+    uint64                    m_maxNodes;
+    bool                      m_printUciInfo;
+
     // stores the refutation to the previous move
     Move    m_counterMoveTable[Piece::PieceCount][64];
 
@@ -204,6 +359,10 @@ private:
         uint64  drawsDetected;
         uint64  killersIllegal;
         uint64  numNullReductions;
+        uint64  perftTableHits;
+        uint64  evalCacheHits;
+        uint64  evalCacheMisses;
+        uint64  lazyEvalExits;
     } m_searchValues;
 
     bool IsMoveGoodForQsearch(
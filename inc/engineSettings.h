@@ -50,6 +50,9 @@ static void SetupInitialSearchSettings(SearchSettings* pSettings)
     pSettings->doNullMoveReduction      = true;
     pSettings->nullReductionSearchDepth = 4;
     pSettings->nullReductionDepth       = 1;
+
+    pSettings->lazyEval               = true;
+    pSettings->lazyEvalMargin         = 2 * PieceScores::PawnScore;
 }
 
 enum EngineFlags : uint64
@@ -82,6 +85,8 @@ enum EngineFlags : uint64
     NoNullReduction              = 1 << 27,
     StrongNullReduction          = 1 << 28,
 
+    NoLazyEval                   = 1 << 29,
+
     Default         =   0,
     NoPrune         =   NoLateMovePrune         |
                         NoMultiCut              |
@@ -108,7 +113,8 @@ enum EngineFlags : uint64
     NoEnhancements   =  NoPrune          |
                         NoKiller         |
                         NoRecaptureFirst |
-                        NoNullWindow,
+                        NoNullWindow     |
+                        NoLazyEval,
 
 
     ErrorFlag = 0xFFFFFFFFFFFFFFFF,
@@ -144,6 +150,7 @@ static EngineFlags GetFlagFromString(std::string flagStr)
     flagMap["nodeltaprune"]                = EngineFlags::NoDeltaPrune;
     flagMap["strongdeltaprune"]            = EngineFlags::StrongDeltaPrune;
     flagMap["nonullreduction"]             = EngineFlags::NoNullReduction;
+    flagMap["nolazyeval"]                  = EngineFlags::NoLazyEval;
 
     // Check if the value exists in the map
     EngineFlags flag = EngineFlags::ErrorFlag;
@@ -258,6 +265,11 @@ static SearchSettings GetSearchSetting(EngineFlags flags)
         settings.nullReductionDepth = 3;
     }
 
+    if (IsFlagSet(flags, NoLazyEval))
+    {
+        settings.lazyEval = false;
+    }
+
     return settings;
 }
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../inc/util.h"
+#include <intrin.h>
+#include <atomic>
+
+// Static evals by zobrist key.  Qsearch scores every node for stand pat, main search scores the
+// same node again for futility pruning, and transpositions get scored as many times as they're
+// reached, so the same board gets evaluated over and over.
+
+// Most of the hits are on boards scored a few nodes earlier, like a futility eval and the qsearch
+// stand pat right after it, so a cache small enough to stay in the core's own caches gets most of
+// them.  A big one hits more often, but misses to memory on nearly every probe, which costs more
+// than ScoreBoard does.
+constexpr uint32 DefaultEvalCacheSizeKB = 64;
+
+// Same lockless scheme as TransTableEntry.  data is the score ScoreBoard<isWhite> gave for the
+// side to move, which is part of the key.
+struct EvalCacheEntry
+{
+    std::atomic<uint64> keyXorData;   // 8
+    std::atomic<uint64> data;         // 8
+};
+
+static_assert(sizeof(EvalCacheEntry) == 16);
+
+// Shared by every search thread like the transposition table.  One entry per index, and a store
+// always replaces what's there: a static eval costs the same to redo whichever one is lost.
+class EvalCache
+{
+public:
+    EvalCache();
+    ~EvalCache();
+
+    void Init(uint32 sizeKB);
+    void Destroy();
+
+    // Reallocates the cache to hold as many entries as fit in sizeKB, which also clears it.
+    void SetSizeKB(uint32 sizeKB) { Init(sizeKB); }
+    uint32 GetSizeKB() { return m_sizeKB; }
+
+    // Returns true and sets *pScore if zobKey's score is in the cache.
+    bool ProbeCache(uint64 zobKey, int32* pScore)
+    {
+        EvalCacheEntry* pEntry     = &(m_pTable[HashZobKey(zobKey)]);
+        const uint64    keyXorData = pEntry->keyXorData.load(std::memory_order_relaxed);
+        const uint64    data       = pEntry->data.load(std::memory_order_relaxed);
+
+        *pScore = static_cast<int32>(static_cast<int64>(data));
+        return (keyXorData ^ data) == zobKey;
+    }
+
+    void InsertToCache(uint64 zobKey, int32 score)
+    {
+        EvalCacheEntry* pEntry = &(m_pTable[HashZobKey(zobKey)]);
+        const uint64    data   = static_cast<uint64>(static_cast<int64>(score));
+
+        pEntry->keyXorData.store(zobKey ^ data, std::memory_order_relaxed);
+        pEntry->data.store(data, std::memory_order_relaxed);
+    }
+
+    void ResetCache();
+private:
+    // Same multiply-high indexing as the transposition table.
+    uint32 HashZobKey(uint64 zobKey) { return static_cast<uint32>(__umulh(zobKey, m_numEntries)); }
+
+    EvalCacheEntry* m_pTable;
+    uint32          m_sizeKB;
+    uint32          m_numEntries;
+};
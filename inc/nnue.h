@@ -0,0 +1,117 @@
+#pragma once
+
+#include "util.h"
+#include <string>
+
+// Efficiently updatable neural network eval, the alternative to Board::ScoreBoard.
+//
+// The network is 768 -> 256x2 -> 1.  The inputs are one per (colour, piece type, square), and
+// each side has its own 256 wide first layer output (its accumulator) with the board seen from its
+// side: its own pieces are the first 384 inputs and the board is flipped for black.  The output
+// layer reads the side to move's accumulator then the other side's, each clipped to [0, QA].
+//
+// Making a move only turns on and off the inputs of the few pieces it touches, so Board keeps an
+// accumulator per ply and works each one out from the ply before it by adding and subtracting rows
+// of the feature weights, instead of running the 768 inputs through the first layer every eval.
+
+constexpr uint32 NnueNumInputs     = 768;
+constexpr uint32 NnueHiddenSize    = 256;
+
+// Quantization of the first layer and of the output weights, and centipawns per unit of output.
+constexpr int32  NnueQuantA        = 255;
+constexpr int32  NnueQuantB        = 64;
+constexpr int32  NnueEvalScale     = 400;
+
+// Looked for in the working directory at startup.  Without it the engine uses ScoreBoard.
+constexpr const char* DefaultNnueFileName = "nnue.bin";
+
+enum NnuePerspective : uint32
+{
+    WhitePerspective = 0,
+    BlackPerspective = 1,
+
+    NumPerspectives  = 2,
+};
+
+// Both sides' first layer outputs for one ply, before the clipping.
+struct alignas(64) NnueAccumulator
+{
+    int16 values[NumPerspectives][NnueHiddenSize];
+};
+
+// The pieces a move turned on and off.  A castle moves two pieces, and a promotion that captures
+// takes off the pawn and the captured piece, so there are never more than two of each.
+struct NnueDelta
+{
+    uint32 numAdded;
+    uint32 numRemoved;
+    uint32 addedPiece[2];
+    uint32 addedIdx[2];
+    uint32 removedPiece[2];
+    uint32 removedIdx[2];
+};
+
+// How the accumulator updates and the output layer are run.  Picked once at startup from what the
+// cpu supports, the same way as the slider attacks.
+enum class NnueBackend : uint32
+{
+    Scalar = 0,
+    Avx2   = 1,
+};
+
+extern NnueBackend ActiveNnueBackend;
+
+// True if the cpu and the OS both support AVX2.
+bool CpuHasAvx2();
+
+void SelectNnueBackend();
+
+const char* GetNnueBackendName(NnueBackend backend);
+
+// Pieces are in Board's Piece order, wKing through bPawn, and squares are 0-63 from a1.  The
+// weights are read only once loaded, so every search thread's board shares the one network.
+class NnueNetwork
+{
+public:
+    NnueNetwork();
+    ~NnueNetwork();
+
+    // The file is the raw little endian int16 weights with no header: the feature weights as 768
+    // rows of 256, the 256 feature biases, the 512 output weights, and the output bias, padded to a
+    // multiple of 64 bytes or not.  Leaves the network unloaded and returns false if the file isn't
+    // that size.
+    bool LoadFromFile(const char* pFileName);
+
+    bool IsLoaded() const { return m_isLoaded; }
+
+    const std::string& GetFileName() const { return m_fileName; }
+
+    // Runs every piece on the board through the first layer.  mailbox holds NoPiece (12) on
+    // empty squares.
+    void RefreshAccumulator(const uint8* pMailbox, NnueAccumulator* pAccumulator) const;
+
+    // *pChild is *pParent with delta's pieces turned on and off, in one pass over each side.
+    void UpdateAccumulator(const NnueAccumulator& parent,
+                           const NnueDelta&       delta,
+                           NnueAccumulator*       pChild) const;
+
+    // Centipawns for the side to move.
+    int32 Evaluate(const NnueAccumulator& accumulator, bool isWhiteTurn) const;
+
+private:
+    template<NnueBackend backend>
+    void UpdateAccumulatorWithBackend(const NnueAccumulator& parent,
+                                      const NnueDelta&       delta,
+                                      NnueAccumulator*       pChild) const;
+
+    template<NnueBackend backend>
+    int32 OutputLayerWithBackend(const int16* pUs, const int16* pThem) const;
+
+    alignas(64) int16 m_featureWeights[NnueNumInputs][NnueHiddenSize];
+    alignas(64) int16 m_featureBiases[NnueHiddenSize];
+    alignas(64) int16 m_outputWeights[NumPerspectives * NnueHiddenSize];
+    int16             m_outputBias;
+
+    std::string       m_fileName;
+    bool              m_isLoaded;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../inc/util.h"
+
+// The pawn terms of the eval only depend on where the pawns are, and the pawns hardly ever move
+// compared to everything else, so they're looked up by BoardInfo::pawnKey instead of being worked
+// out again at every node.  The scores are white - black, before the game phase multipliers.
+struct PawnHashEntry
+{
+    uint64 pawnKey;
+    uint64 whitePassedPawns;
+    uint64 blackPassedPawns;
+    int16  structureScore;      // chains and doubled pawns
+    int16  passedPawnScore;
+};
+
+static_assert(sizeof(PawnHashEntry) == 32);
+
+// 512 KB.  Even long searches only see a few thousand pawn structures.
+constexpr uint32 DefaultPawnHashTableEntries = 1u << 14;
+
+// Only ever used by one search thread, so unlike the transposition table there's nothing atomic
+// about it.  An entry that is still zeroed has the key of a board with no pawns, and its scores and
+// passed pawns are what that board would have anyway.
+class PawnHashTable
+{
+public:
+    PawnHashTable();
+    ~PawnHashTable();
+
+    void Init(uint32 numEntries);
+    void Destroy();
+
+    bool IsInitialized() { return m_pTable != nullptr; }
+
+    // The entry pawnKey goes in.  It's only for this pawnKey if pEntry->pawnKey matches, otherwise
+    // the caller fills it in.
+    PawnHashEntry* GetEntry(uint64 pawnKey) { return &(m_pTable[pawnKey & m_indexMask]); }
+
+    void CountProbe(bool hit) { m_numProbes++; m_numHits += (hit) ? 1 : 0; }
+
+    uint64 GetNumProbes() { return m_numProbes; }
+    uint64 GetNumHits()   { return m_numHits;   }
+
+    void ResetStats() { m_numProbes = 0ull; m_numHits = 0ull; }
+
+    void ResetTable();
+private:
+    PawnHashEntry* m_pTable;
+    uint64         m_indexMask;
+
+    uint64         m_numProbes;
+    uint64         m_numHits;
+};
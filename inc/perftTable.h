@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../inc/util.h"
+#include <atomic>
+
+// Perft only needs to know how many leaves are under a position, so an entry is the position's
+// key, the depth it was counted to, and the count.  The count gets the low 56 bits of the data and
+// the depth the high 8, which is more than enough for either.
+constexpr uint32 PerftCountBits  = 56;
+constexpr uint64 PerftCountMask  = (1ull << PerftCountBits) - 1;
+
+// Depth 1 is just the move count, which is cheaper to generate than to look up.
+constexpr uint32 PerftTableMinDepth = 2;
+
+constexpr uint32 DefaultPerftTableSizeMB = 256;
+
+// Same lockless scheme as TransTableEntry.  The full key is stored xor'd with the data, so a probe
+// only matches if the key, the depth and the count all came from the same write.
+struct PerftTableEntry
+{
+    std::atomic<uint64> keyXorData;   // 8
+    std::atomic<uint64> data;         // 8
+};
+
+constexpr uint32 PerftEntriesPerBucket = 4;
+struct alignas(64) PerftTableBucket
+{
+    PerftTableEntry entries[PerftEntriesPerBucket];
+};
+
+static_assert(sizeof(PerftTableBucket) == 64);
+
+class PerftTable
+{
+public:
+    PerftTable();
+    ~PerftTable();
+
+    void Init(uint32 sizeMB);
+    void Destroy();
+
+    bool IsInitialized() { return m_pTable != nullptr; }
+    uint32 GetSizeMB()   { return m_sizeMB; }
+
+    // Returns true and sets *pCount if this position has already been counted to this depth.
+    bool ProbeTable(uint64 zobKey, uint32 depth, uint64* pCount);
+
+    void InsertToTable(uint64 zobKey, uint32 depth, uint64 count);
+
+    void ResetTable();
+private:
+    uint32 HashZobKey(uint64 zobKey);
+
+    PerftTableBucket* m_pTable;
+    uint32            m_sizeMB;
+    uint32            m_numBuckets;
+};
@@ -0,0 +1,120 @@
+#pragma once
+#include "util.h"
+
+// Piece square tables for white, laid out the way the board prints: rank 8 on the first row and
+// the a file on the left, so table[idx ^ 56] is the score for a white piece on square idx.  Black
+// uses the same tables flipped top to bottom.  The scores are on top of the piece's material
+// value, in the same units.
+
+// Unpushed pawns lose points and advanced ones gain them, on top of wanting the center.
+constexpr int16 PawnMidgameTable[64] =
+{
+      0,   0,   0,   0,   0,   0,   0,   0,
+     20,  20,  20,  20,  20,  20,  20,  20,
+     20,  20,  25,  30,  30,  25,  20,  20,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      5,   5,  10,  20,  20,  10,   5,   5,
+     -5,  -5,  -5,   0,   0,  -5,  -5,  -5,
+     -5,  -5,  -5, -20, -20,  -5,  -5,  -5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+// Pushing pawns is worth twice as much once there's nothing left to stop them.
+constexpr int16 PawnEndgameTable[64] =
+{
+      0,   0,   0,   0,   0,   0,   0,   0,
+     40,  40,  40,  40,  40,  40,  40,  40,
+     40,  40,  40,  40,  40,  40,  40,  40,
+     10,  10,  10,  10,  10,  10,  10,  10,
+     10,  10,  10,  10,  10,  10,  10,  10,
+    -10, -10, -10, -10, -10, -10, -10, -10,
+    -10, -10, -10, -10, -10, -10, -10, -10,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+constexpr int16 KnightTable[64] =
+{
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50,
+};
+
+constexpr int16 BishopTable[64] =
+{
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20,
+};
+
+constexpr int16 RookMidgameTable[64] =
+{
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0,
+};
+
+// The seventh rank still matters, but a rook is fine anywhere else once the board opens up.
+constexpr int16 RookEndgameTable[64] =
+{
+      0,   0,   0,   0,   0,   0,   0,   0,
+     10,  10,  10,  10,  10,  10,  10,  10,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+constexpr int16 QueenTable[64] =
+{
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+};
+
+// Tucked away behind the pawns while there are pieces around to attack it.
+constexpr int16 KingMidgameTable[64] =
+{
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20,
+};
+
+// In the middle of the board once there aren't.
+constexpr int16 KingEndgameTable[64] =
+{
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50,
+};
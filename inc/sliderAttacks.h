@@ -0,0 +1,83 @@
+#pragma once
+
+#include "util.h"
+#include "immintrin.h"
+
+// Fancy magic bitboard lookup for sliding piece attacks.  Each square has a mask of the squares
+// that can block the slider (the board edge is left off since a piece there can't block anything),
+// and a magic number that perfectly hashes every blocker configuration under that mask into that
+// square's slice of a shared attack table.  Looking up an attack set is then a single and,
+// multiply, shift, and load instead of casting a ray in each of the 4 directions.
+//
+// With BMI2, pext(occupied, mask) is already a perfect index into the square's slice, so the PEXT
+// tables skip the multiply and shift (and the magic numbers) entirely.
+struct SliderMagic
+{
+    uint64* pAttacks;       // This square's slice of the shared attack table
+    uint64* pPextAttacks;   // This square's slice of the pext attack table
+    uint64  mask;           // Relevant blocker squares
+    uint64  magic;
+    uint32  shift;          // 64 - PopCount(mask)
+};
+
+// Which implementation Board uses to get slider attacks.  Picked once at startup by timing each
+// backend the cpu supports, so one binary runs the fastest path on every machine.
+enum class SliderBackend : uint32
+{
+    Ray   = 0,  // Board::CastRayToBlocker in each direction
+    Magic = 1,
+    Pext  = 2,  // Needs BMI2
+};
+
+// 102400 rook entries and 5248 bishop entries with the standard relevant occupancy masks.
+constexpr uint32 RookAttackTableSize   = 0x19000;
+constexpr uint32 BishopAttackTableSize = 0x1480;
+
+extern SliderMagic RookMagics[64];
+extern SliderMagic BishopMagics[64];
+
+// RayToSquareTable[from][to] holds the squares from 'from' (exclusive) to 'to' (inclusive) if
+// they share a rank, file, or diagonal, and 0 otherwise.
+extern uint64 RayToSquareTable[64][64];
+
+extern SliderBackend ActiveSliderBackend;
+
+// Builds the magic, pext, and ray tables.  The tables are shared by all boards, so this only does
+// work the first time it's called.  The pext tables are only built if CpuHasFastPext().  Returns
+// Result::Error if a magic number collides or the slices don't fill the tables exactly.
+Result InitSliderAttackTables();
+
+// True if the cpu has BMI2 and pext isn't microcoded.  AMD before Zen 3 has BMI2, but pext takes
+// hundreds of cycles there, so it's treated as not available.
+bool CpuHasFastPext();
+
+const char* GetSliderBackendName(SliderBackend backend);
+
+static inline uint32 GetMagicIndex(const SliderMagic& magic, uint64 occupied)
+{
+    return static_cast<uint32>(((occupied & magic.mask) * magic.magic) >> magic.shift);
+}
+
+static inline uint64 GetRookAttacksMagic(uint32 idx, uint64 occupied)
+{
+    const SliderMagic& magic = RookMagics[idx];
+    return magic.pAttacks[GetMagicIndex(magic, occupied)];
+}
+
+static inline uint64 GetBishopAttacksMagic(uint32 idx, uint64 occupied)
+{
+    const SliderMagic& magic = BishopMagics[idx];
+    return magic.pAttacks[GetMagicIndex(magic, occupied)];
+}
+
+static inline uint64 GetRookAttacksPext(uint32 idx, uint64 occupied)
+{
+    const SliderMagic& magic = RookMagics[idx];
+    return magic.pPextAttacks[_pext_u64(occupied, magic.mask)];
+}
+
+static inline uint64 GetBishopAttacksPext(uint32 idx, uint64 occupied)
+{
+    const SliderMagic& magic = BishopMagics[idx];
+    return magic.pPextAttacks[_pext_u64(occupied, magic.mask)];
+}
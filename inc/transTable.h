@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../inc/board.h"
+#include <atomic>
 
 enum class TTScoreType : uint8
 {
@@ -11,6 +12,11 @@ enum class TTScoreType : uint8
 
 constexpr uint32 TTScoreTypeSize = sizeof(TTScoreType);
 
+// Main search and qsearch share one table.  Qsearch stores and probes everything at this depth,
+// and main search entries are always deeper.  Each only takes scores from its own kind of entry,
+// but either can use the other's move for ordering.
+constexpr int32 TTQSearchDepth = 0;
+
 // Takes TransTableEntry from 48 bytes to 16 (should fit in 1 cache line).
 struct TinyMove
 {
@@ -30,13 +36,60 @@ struct TinyMove
     };
 };
 
+// genBound packs the TTScoreType into the low 2 bits and the search generation the entry was
+// written in into the high 6.
+constexpr uint8  TTBoundMask        = 0x03;
+constexpr uint32 TTGenerationShift  = 2;
+constexpr uint8  TTGenerationMask   = 0x3F;
+
+struct TransTableData
+{
+    union
+    {
+        struct
+        {
+            TinyMove    tinyMove;   // 4
+            int16       score;      // 2
+            uint8       genBound;   // 1
+            int8        depth;      // 1
+        };
+
+        uint64 u64all;
+    };
+
+    TTScoreType GetType()       const { return static_cast<TTScoreType>(genBound & TTBoundMask); }
+    uint8       GetGeneration() const { return genBound >> TTGenerationShift; }
+};
+
+static_assert(sizeof(TransTableData) == sizeof(uint64));
+
+// The table is shared by all the search threads without any locks.  Each half of an entry is
+// written with a single 8 byte store, so a reader can never see half of a key or half of the
+// data, but it can see the key from one write and the data from another.  To catch that, the key
+// is stored xor'd with the data, and a torn entry just won't match the key being probed.
 struct TransTableEntry
 {
-    uint64      zobKey;     // 8
-    TinyMove    tinyMove;   // 4
-    int16       score;      // 2
-    TTScoreType type;       // 1
-    int8        depth;      // 1
+    std::atomic<uint64> keyXorData;   // 8
+    std::atomic<uint64> data;         // 8
+};
+
+// A key can only go in one bucket, but it can go in any of the entries in it.  One bucket is one
+// cache line, so a probe only ever misses cache once.
+constexpr uint32 TTEntriesPerBucket = 4;
+struct alignas(64) TransTableBucket
+{
+    TransTableEntry entries[TTEntriesPerBucket];
+};
+
+static_assert(sizeof(TransTableBucket) == 64);
+
+// What backs the table's memory.  Probes land on random pages, so on a big table almost every
+// probe is a TLB miss with 4KB pages, and far fewer are with 2MB ones.
+enum class TTAllocMode : uint8
+{
+    Normal          = 0,
+    LargePages      = 1, // Explicit huge pages (MAP_HUGETLB, or MEM_LARGE_PAGES on Windows)
+    TransparentHuge = 2, // Normal pages the kernel was asked to promote (MADV_HUGEPAGE)
 };
 
 class TranspositionTable
@@ -45,9 +98,26 @@ public:
     TranspositionTable();
     ~TranspositionTable();
 
-    void Init(uint32 tableSize);
+    // interleaveNuma spreads the table's pages evenly over every NUMA node, so no one socket's
+    // memory controller serves all the probes.  It does nothing on a single node machine.  Can be
+    // called again to change it, which reallocates the table the same as SetSizeMB.
+    bool Init(uint32 sizeMB, bool interleaveNuma = false);
     void Destroy();
 
+    // Reallocates the table to hold as many buckets as fit in sizeMB.  Everything in the table is
+    // lost.  Returns false if sizeMB couldn't be allocated.  The old table is kept then (cleared),
+    // or if there wasn't one, sizeMB is halved until a table fits.
+    bool SetSizeMB(uint32 sizeMB);
+    uint32 GetSizeMB() { return m_sizeMB; }
+
+    TTAllocMode GetAllocMode()    { return m_allocMode; }
+    uint32      GetNumaNodes()    { return m_numaNodes; }
+    const char* GetAllocModeStr();
+
+    // Times random probes with multiply-high indexing against modulo indexing on this table, and
+    // prints the average ns per probe for each.
+    void BenchmarkProbes(uint32 numProbes);
+
     Move ProbeTable(uint64 zobKey, int32 depth, int32 alpha, int32 beta);
 
     void InsertToTable(uint64 zobKey, int32 depth, const Move& move, TTScoreType type);
@@ -55,16 +125,42 @@ public:
     void PrefetchEntry(uint64 zobKey);
 
     void ResetTable();
+
+    // Entries written before the last NewSearch() are the first to be replaced.  Should be called
+    // once per search, so old positions age out without having to clear the table.
+    void NewSearch() { m_generation = (m_generation + 1) & TTGenerationMask; }
+
+    // Permille of the table written during the current search, the same as UCI's hashfull.  Only
+    // samples the start of the table.
+    uint32 GetHashFull();
 private:
 
     uint32 HashZobKey(uint64 zobKey);
 
-    void ResetTableEntry(int32 idx);
+    template<bool useModulo>
+    uint64 TimeProbes(uint32 numProbes, uint64* pSink);
+
+    void ResetTableEntry(TransTableEntry* pEntry);
+    void ResetBuckets(uint32 firstBucket, uint32 endBucket);
+
+    // Returns nullptr if the memory couldn't be had.  Doesn't touch the current table.
+    TransTableBucket* AllocTable(uint64       numBytes,
+                                 uint64*      pAllocBytes,
+                                 TTAllocMode* pAllocMode,
+                                 uint32*      pNumaNodes);
+    void FreeTable(TransTableBucket* pTable, uint64 allocBytes, TTAllocMode allocMode);
+
+    int32 GetReplaceValue(const TransTableData& tableData);
 
     Move TinyMoveToMove(const TinyMove& tinyMove);
     TinyMove MoveToTinyMove(const Move& move);
 
-    TransTableEntry* m_pTable;
-    uint32 m_tableSize;
-    uint32 m_hashVal;
+    TransTableBucket* m_pTable;
+    uint64            m_allocBytes;     // Can be more than the buckets use, rounded up to the page
+    uint32            m_sizeMB;
+    uint32            m_numBuckets;
+    uint32            m_numaNodes;      // Nodes the table is interleaved over, 1 if it isn't
+    TTAllocMode       m_allocMode;
+    bool              m_interleaveNuma;
+    uint8             m_generation;
 };
\ No newline at end of file
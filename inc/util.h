@@ -51,6 +51,7 @@ typedef long                int32;
 typedef long long           int64;
 
 typedef short               int16;
+typedef unsigned short      uint16;
 
 typedef unsigned long       uint32;
 typedef unsigned long long  uint64;
@@ -1,7 +1,9 @@
 #include "../inc/board.h"
 #include "../inc/util.h"
 #include "../inc/bitHelper.h"
+#include "../inc/sliderAttacks.h"
 #include <random>
+#include <algorithm>
 Board::Board()
 :
 m_pieces(),
@@ -9,9 +11,16 @@ m_boardState(),
 m_pRayTable(),
 m_ppZobristArray(nullptr),
 m_prevZobKeyVec(),
+m_undoStack(MaxUndoStackSize),
+m_undoStackSize(0),
+m_moveGenMasks(MaxUndoStackSize + 1),
+m_attackInfo(MaxUndoStackSize + 1),
+m_pPawnHashTable(nullptr),
+m_pNnueNetwork(nullptr),
+m_nnueAccumulators(),
+m_nnueValidPly(0),
 m_fancyPrint(false)
 {
-    constexpr uint32 PrevZobKeyVecLength = 1024;
     // unlikely a game will go for more than 512 moves... if it does we segfault...
     m_prevZobKeyVec.reserve(PrevZobKeyVecLength);
     for (uint32 idx = 0; idx < PrevZobKeyVecLength; idx++)
@@ -25,11 +34,73 @@ Board::~Board()
 
 }
 
+Board::Board(const Board& other)
+:
+m_prevZobKeyVec(),
+m_undoStack(MaxUndoStackSize),
+m_undoStackSize(0),
+m_moveGenMasks(MaxUndoStackSize + 1),
+m_attackInfo(MaxUndoStackSize + 1),
+m_pNnueNetwork(nullptr),
+m_nnueAccumulators(),
+m_nnueValidPly(0)
+{
+    *this = other;
+}
+
+Board& Board::operator=(const Board& other)
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    memcpy(&(m_pieces[0]), &(other.m_pieces[0]), sizeof(m_pieces));
+    memcpy(&(m_mailbox[0]), &(other.m_mailbox[0]), sizeof(m_mailbox));
+    memcpy(&(m_pRayTable[0][0]), &(other.m_pRayTable[0][0]), sizeof(m_pRayTable));
+    memcpy(&(m_numPieceArr[0]), &(other.m_numPieceArr[0]), sizeof(m_numPieceArr));
+
+    m_prevZobKeyVec  = other.m_prevZobKeyVec;
+    m_ppZobristArray = other.m_ppZobristArray;
+    m_boardState     = other.m_boardState;
+    m_pPawnHashTable = other.m_pPawnHashTable;
+    m_fancyPrint     = other.m_fancyPrint;
+
+    const uint32 numPlies = other.m_undoStackSize + 1;
+    m_undoStackSize = other.m_undoStackSize;
+    std::copy_n(other.m_undoStack.begin(),    m_undoStackSize, m_undoStack.begin());
+    std::copy_n(other.m_moveGenMasks.begin(), numPlies,        m_moveGenMasks.begin());
+    std::copy_n(other.m_attackInfo.begin(),   numPlies,        m_attackInfo.begin());
+
+    m_pNnueNetwork = other.m_pNnueNetwork;
+    m_nnueValidPly = other.m_nnueValidPly;
+    if (m_pNnueNetwork != nullptr)
+    {
+        m_nnueAccumulators.resize(MaxUndoStackSize + 1);
+        std::copy_n(other.m_nnueAccumulators.begin(), numPlies, m_nnueAccumulators.begin());
+    }
+    else
+    {
+        m_nnueAccumulators.clear();
+        m_nnueAccumulators.shrink_to_fit();
+    }
+
+    return *this;
+}
+
 Result Board::Init()
 {
     InitZobArray();
     ResetBoard();
     GenerateRayTable();
+
+    const Result sliderResult = InitSliderAttackTables();
+    if (sliderResult != Result::Success)
+    {
+        std::cout << "Slider attack tables failed to verify" << std::endl;
+        return sliderResult;
+    }
+    SelectSliderBackend();
     ResetPieceScore();
 
     return Result::ErrorNotImplemented;
@@ -51,7 +122,11 @@ void Board::SetBoardFromFEN(std::string fenStr)
     uint32 fenStrIdx       = 0;
     const uint32 fenStrLen = fenStr.length();
 
-    m_boardState = {};
+    m_boardState                = {};
+    m_boardState.lastCaptureIdx = NoSquare;
+    m_undoStackSize             = 0;
+    GetMasks()                  = {};
+    InvalidateAttackInfo();
 
     for (uint32 idx = 0; idx < Piece::PieceCount; idx++)
     {
@@ -157,7 +232,7 @@ void Board::SetBoardFromFEN(std::string fenStr)
 
     // handle castling
     m_boardState.castleMask = 0;
-    while ((fenStr[fenStrIdx] != ' ') && (fenStr[fenStrIdx] != '-'))
+    while ((fenStrIdx < fenStrLen) && (fenStr[fenStrIdx] != ' ') && (fenStr[fenStrIdx] != '-'))
     {
         if (fenStr[fenStrIdx] == 'K')
         {
@@ -182,8 +257,26 @@ void Board::SetBoardFromFEN(std::string fenStr)
         fenStrIdx++;
     }
 
-    // handle EP here
-    CH_MESSAGE("Finish En Passant");
+    if ((fenStrIdx < fenStrLen) && (fenStr[fenStrIdx] == '-'))
+    {
+        fenStrIdx++;
+    }
+    while ((fenStrIdx < fenStrLen) && (fenStr[fenStrIdx] == ' '))
+    {
+        fenStrIdx++;
+    }
+
+    // The en passant square is the one the pawn skipped over, same as the fen.
+    m_boardState.enPassantSquare = 0ull;
+    if ((fenStrIdx + 1 < fenStrLen) && (fenStr[fenStrIdx] != '-'))
+    {
+        uint32 epFile = fenStr[fenStrIdx] - 'a';
+        uint32 epRank = fenStr[fenStrIdx + 1] - '1';
+        if ((epFile < 8) && (epRank < 8))
+        {
+            m_boardState.enPassantSquare = IndexToPosition(epFile + epRank * 8);
+        }
+    }
 
     // Finish setting up board here
     m_boardState.whitePieces = 0ull;
@@ -200,11 +293,17 @@ void Board::SetBoardFromFEN(std::string fenStr)
             m_boardState.blackPieces |= m_pieces[idx];
         }
     }
-    m_boardState.allPieces = m_boardState.whitePieces | m_boardState.blackPieces;
+    ResetMailbox();
 
     m_boardState.zobristKey = 0ull;
     ResetZobKey();
+    ResetPawnKey();
     ResetPieceScore();
+
+    if (m_pNnueNetwork != nullptr)
+    {
+        RefreshNnueAccumulator();
+    }
 }
 
 void Board::ResetBoard()
@@ -258,10 +357,10 @@ void Board::PrintBoard(uint64 pieces)
         pieceBuf[file][rank] = '#';
     }
 
-    if (m_boardState.lastPosMoved != 0ull)
+    if (m_boardState.previousMove.IsNull() == false)
     {
-        uint32 file = GetFile(m_boardState.lastPosMoved);
-        uint32 rank = GetRank(m_boardState.lastPosMoved);
+        uint32 file = GetFile(m_boardState.previousMove.FromPos());
+        uint32 rank = GetRank(m_boardState.previousMove.FromPos());
 
         pieceBuf[file][rank] = '+';
     }
@@ -353,26 +452,7 @@ void Board::PrintBoard(uint64 pieces)
 
 Piece Board::GetPieceFromPos(uint64 pos)
 {
-    Piece retPiece = Piece::NoPiece;
-    if (IsWhite(pos))
-    {
-        if (IsWhiteKing(pos))        retPiece = Piece::wKing;
-        else if (IsWhiteQueen(pos))  retPiece = Piece::wQueen;
-        else if (IsWhiteRook(pos))   retPiece = Piece::wRook;
-        else if (IsWhiteBishop(pos)) retPiece = Piece::wBishop;
-        else if (IsWhiteKnight(pos)) retPiece = Piece::wKnight;
-        else if (IsWhitePawn(pos))   retPiece = Piece::wPawn;
-    }
-    else if (IsBlack(pos))
-    {
-        if (IsBlackKing(pos))        retPiece = Piece::bKing;
-        else if (IsBlackQueen(pos))  retPiece = Piece::bQueen;
-        else if (IsBlackRook(pos))   retPiece = Piece::bRook;
-        else if (IsBlackBishop(pos)) retPiece = Piece::bBishop;
-        else if (IsBlackKnight(pos)) retPiece = Piece::bKnight;
-        else if (IsBlackPawn(pos))   retPiece = Piece::bPawn;
-    }
-    return retPiece;
+    return m_mailbox[GetIndex(pos)];
 }
 
 bool Board::VerifyBoard()
@@ -381,16 +461,13 @@ bool Board::VerifyBoard()
     // white and black can't occupy the same square
     error |= (m_boardState.whitePieces & m_boardState.blackPieces) != 0;
 
-    // white and black need to make up all the pieces
-    error |= (m_boardState.whitePieces | m_boardState.blackPieces) != m_boardState.allPieces;
-
     // no pieces overlap
     uint64 whiteMask = 0ull;
     uint64 blackMask = 0ull;
-    for (uint32 idx = wPawn; idx <= bKing; idx++)
+    for (uint32 idx = wKing; idx <= bPawn; idx++)
     {
-        error |= whiteMask & m_pieces[idx];
-        error |= blackMask & m_pieces[idx];
+        error |= (whiteMask & m_pieces[idx]) != 0ull;
+        error |= (blackMask & m_pieces[idx]) != 0ull;
         if (IsWhitePiece(static_cast<Piece>(idx)))
         {
             whiteMask |= m_pieces[idx];
@@ -411,10 +488,19 @@ bool Board::VerifyBoard()
     error |= PopCount(BKing()) != 1;
 
     // Can't ever have more than 32 pieces
-    error |= PopCount(m_boardState.allPieces) > MaxPieces;
+    error |= PopCount(GetAllPieces()) > MaxPieces;
     error |= PopCount(m_boardState.whitePieces) > MaxPiecesPerSide;
     error |= PopCount(m_boardState.blackPieces) > MaxPiecesPerSide;
 
+    // The mailbox has to agree with the bitboards
+    for (uint32 idx = 0; idx < 64; idx++)
+    {
+        const Piece piece = m_mailbox[idx];
+        const uint64 pos  = IndexToPosition(idx);
+        error |= (piece == Piece::NoPiece) ? ((GetAllPieces() & pos) != 0ull) :
+                                             ((m_pieces[piece] & pos) == 0ull);
+    }
+
     // Make sure we properly reconstructed the board
     error |= m_boardState.whitePieces != whiteMask;
     error |= m_boardState.blackPieces != blackMask;
@@ -422,7 +508,43 @@ bool Board::VerifyBoard()
     // This has an internal assert.
     ResetZobKey();
 
-    return error != 0;
+    // The piece square scores are kept up by the make functions, recount them from the mailbox.
+    int32 midgameScore = 0;
+    int32 endgameScore = 0;
+    for (uint32 idx = 0; idx < 64; idx++)
+    {
+        midgameScore += PieceSquareTable.midgame[m_mailbox[idx]][idx];
+        endgameScore += PieceSquareTable.endgame[m_mailbox[idx]][idx];
+    }
+    error |= midgameScore != m_boardState.midgamePieceSquareScore;
+    error |= endgameScore != m_boardState.endgamePieceSquareScore;
+
+    uint64 pawnKey = 0ull;
+    for (uint32 idx = 0; idx < 64; idx++)
+    {
+        pawnKey ^= PawnZobristTable.keys[m_mailbox[idx]][idx];
+    }
+    error |= pawnKey != m_boardState.pawnKey;
+
+    // The piece counts and material are kept up by the make functions too, recount them from the
+    // bitboards the same as ResetPieceScore.
+    int32 pieceValueScore    = 0;
+    int32 totalMaterialValue = 0;
+    for (uint32 idx = wKing; idx <= bPawn; idx++)
+    {
+        const uint32 count = PopCount(m_pieces[idx]);
+        error |= count != m_numPieceArr[idx];
+
+        if ((idx != wKing) && (idx != bKing))
+        {
+            pieceValueScore    += count * PieceValueArray[idx];
+            totalMaterialValue += count * PieceValueArray[idx % 6];
+        }
+    }
+    error |= pieceValueScore    != m_boardState.pieceValueScore;
+    error |= totalMaterialValue != m_boardState.totalMaterialValue;
+
+    return error == 0;
 }
 
 //Precomputes and stores rays in all directions from all positions.
@@ -441,23 +563,25 @@ void Board::GenerateRayTable()
 template<bool isWhite>
 void Board::MakeMove(const Move& move)
 {
+    PushUndoEntry();
+
     m_boardState.previousMove = move;
     bool isCaptureOfNonPawn = (move.toPiece != Piece::NoPiece) &&
                               (move.toPiece != Piece::wPawn)   &&
                               (move.toPiece != Piece::bPawn);
-    m_boardState.lastPosCaptured = (isCaptureOfNonPawn) ? move.toPos : 0ull;
-    m_boardState.lastPosMoved = move.fromPos;
+    m_boardState.lastCaptureIdx = (isCaptureOfNonPawn) ? move.toIdx : NoSquare;
     // Switch the team.
     m_boardState.zobristKey ^= m_ppZobristArray[0][65];
     m_boardState.isWhiteTurn = !m_boardState.isWhiteTurn;
 
     // These aren't valid anymore
-    m_boardState.checkAndPinMasksValid = false;
-    m_boardState.illegalKingMovesValid = false;
+    GetMasks().checkAndPinMasksValid = false;
+    GetMasks().illegalKingMovesValid = false;
+    InvalidateAttackInfo();
 
     if (move.toPiece != Piece::NoPiece)
     {
-        m_boardState.numPieceArr[move.toPiece] -= 1;
+        m_numPieceArr[move.toPiece] -= 1;
 
         // Subtract the value of the piece that was captured
         m_boardState.pieceValueScore -= PieceValueArray[move.toPiece];
@@ -517,24 +641,210 @@ void Board::MakeMove(const Move& move)
 
     UpdateLastIrreversableMove<isWhite>(move);
     m_boardState.currMoveNum++;
+
+    if (m_pNnueNetwork != nullptr)
+    {
+        UpdateNnueAccumulator<isWhite>(move);
+    }
 }
 
 template void Board::MakeMove<true>(const Move& move);
 template void Board::MakeMove<false>(const Move& move);
 
-void Board::UndoMove(BoardInfo* pBoardInfo, uint64* pPieceData)
+void Board::PushUndoEntry()
+{
+    CH_ASSERT(m_undoStackSize < MaxUndoStackSize);
+    SaveUndoEntry(&(m_undoStack[m_undoStackSize]));
+    m_undoStackSize++;
+}
+
+void Board::SaveUndoEntry(BoardInfo* pUndo) const
+{
+    *pUndo = m_boardState;
+}
+
+void Board::SaveUndoEntry(CopyMakeUndoInfo* pUndo) const
+{
+    memcpy(&(pUndo->boardState), &m_boardState, sizeof(BoardInfo));
+    memcpy(&(pUndo->pieces[0]), &(m_pieces[0]), sizeof(m_pieces));
+    memcpy(&(pUndo->mailbox[0]), &(m_mailbox[0]), sizeof(m_mailbox));
+    memcpy(&(pUndo->numPieceArr[0]), &(m_numPieceArr[0]), sizeof(m_numPieceArr));
+}
+
+void Board::RestoreUndoEntry(const BoardInfo& undo)
+{
+    m_boardState = undo;
+}
+
+void Board::RestoreUndoEntry(const CopyMakeUndoInfo& undo)
+{
+    memcpy(&m_boardState, &(undo.boardState), sizeof(BoardInfo));
+    memcpy(&(m_pieces[0]), &(undo.pieces[0]), sizeof(m_pieces));
+    memcpy(&(m_mailbox[0]), &(undo.mailbox[0]), sizeof(m_mailbox));
+    memcpy(&(m_numPieceArr[0]), &(undo.numPieceArr[0]), sizeof(m_numPieceArr));
+}
+
+void Board::SaveSnapshot(BoardSnapshot* pSnapshot) const
+{
+    SaveUndoEntry(&(pSnapshot->position));
+
+    // UpdateLastIrreversableMove can write one past currMoveNum, and IsDrawByRepetition starts
+    // from the even index at or after lastIrreversableMoveNum.
+    const uint32 startIdx = m_boardState.lastIrreversableMoveNum & ~1u;
+    const uint32 endIdx   = std::min<uint32>(m_boardState.currMoveNum + 2, PrevZobKeyVecLength);
+    pSnapshot->repetitionKeys.assign(m_prevZobKeyVec.begin() + startIdx,
+                                     m_prevZobKeyVec.begin() + std::max(startIdx, endIdx));
+}
+
+void Board::RestoreSnapshot(const BoardSnapshot& snapshot)
+{
+    RestoreUndoEntry(snapshot.position);
+
+    const uint32 startIdx = m_boardState.lastIrreversableMoveNum & ~1u;
+    std::copy(snapshot.repetitionKeys.begin(),
+              snapshot.repetitionKeys.end(),
+              m_prevZobKeyVec.begin() + startIdx);
+
+    m_undoStackSize = 0;
+    GetMasks()      = {};
+    InvalidateAttackInfo();
+
+    if (m_pNnueNetwork != nullptr)
+    {
+        RefreshNnueAccumulator();
+    }
+}
+
+bool Board::IsSamePosition(const BoardSnapshot& snapshot) const
+{
+    const BoardInfo& other = snapshot.position.boardState;
+    return (memcmp(&(m_pieces[0]), &(snapshot.position.pieces[0]), sizeof(m_pieces)) == 0) &&
+           (m_boardState.zobristKey              == other.zobristKey)                     &&
+           (m_boardState.isWhiteTurn             == other.isWhiteTurn)                    &&
+           (m_boardState.castleMask              == other.castleMask)                     &&
+           (m_boardState.enPassantSquare         == other.enPassantSquare)                &&
+           (m_boardState.currMoveNum             == other.currMoveNum)                    &&
+           (m_boardState.lastIrreversableMoveNum == other.lastIrreversableMoveNum);
+}
+
+// The ply being unmade to still has its own MoveGenMasks, so only the BoardInfo and the pieces
+// need putting back.
+template<bool isWhite>
+void Board::UnmakeMove()
+{
+    CH_ASSERT(m_undoStackSize > 0);
+    if constexpr (BoardCopyMake == false)
+    {
+        UnmakePieces<isWhite>(m_boardState.previousMove);
+    }
+
+    m_undoStackSize--;
+    RestoreUndoEntry(m_undoStack[m_undoStackSize]);
+}
+
+template void Board::UnmakeMove<true>();
+template void Board::UnmakeMove<false>();
+
+void Board::UnmakeNullMove()
+{
+    CH_ASSERT(m_undoStackSize > 0);
+    m_undoStackSize--;
+    RestoreUndoEntry(m_undoStack[m_undoStackSize]);
+}
+
+// Works the move backwards on the piece bitboards, mailbox and piece counts; the colour boards and
+// material live in BoardInfo and come back with it.  The piece that promoted is read out of the
+// mailbox before it's overwritten.
+template<bool isWhite>
+void Board::UnmakePieces(const Move& move)
+{
+    constexpr Piece teamPawn  = (isWhite) ? Piece::wPawn : Piece::bPawn;
+    constexpr Piece enemyPawn = (isWhite) ? Piece::bPawn : Piece::wPawn;
+    constexpr Piece teamKing  = (isWhite) ? Piece::wKing : Piece::bKing;
+    constexpr Piece teamRook  = (isWhite) ? Piece::wRook : Piece::bRook;
+
+    const uint64 fromPos = move.FromPos();
+    const uint64 toPos   = move.ToPos();
+
+    if ((move.flags & MoveFlags::CastleFlags) != 0)
+    {
+        const bool   kingSide     = (move.flags & (WhiteKingCastle | BlackKingCastle)) != 0;
+        const uint8  rookStartIdx = static_cast<uint8>(move.fromIdx + (kingSide ? 3 : -4));
+        const uint8  rookLandIdx  = static_cast<uint8>(move.fromIdx + (kingSide ? 1 : -1));
+        const uint64 rookMoved    = IndexToPosition(rookStartIdx) | IndexToPosition(rookLandIdx);
+
+        m_pieces[teamKing]  = fromPos;
+        m_pieces[teamRook] ^= rookMoved;
+
+        m_mailbox[move.toIdx]   = Piece::NoPiece;
+        m_mailbox[rookLandIdx]  = Piece::NoPiece;
+        m_mailbox[move.fromIdx] = teamKing;
+        m_mailbox[rookStartIdx] = teamRook;
+    }
+    else if (move.flags == MoveFlags::EnPassant)
+    {
+        // The captured pawn is on the mover's starting rank, in the landing square's column.
+        const uint8 enemyIdx = static_cast<uint8>((move.fromIdx & ~7) | (move.toIdx & 7));
+
+        m_pieces[teamPawn]  ^= fromPos | toPos;
+        m_pieces[enemyPawn] ^= IndexToPosition(enemyIdx);
+
+        m_mailbox[move.fromIdx] = teamPawn;
+        m_mailbox[move.toIdx]   = Piece::NoPiece;
+        m_mailbox[enemyIdx]     = enemyPawn;
+    }
+    else
+    {
+        if ((move.flags & MoveFlags::Promotion) != 0)
+        {
+            const Piece promotionPiece = m_mailbox[move.toIdx];
+            m_pieces[teamPawn]       ^= fromPos;
+            m_pieces[promotionPiece] ^= toPos;
+
+            m_numPieceArr[teamPawn]       += 1;
+            m_numPieceArr[promotionPiece] -= 1;
+        }
+        else
+        {
+            m_pieces[move.fromPiece] ^= fromPos | toPos;
+        }
+
+        // Same as the make, a NoPiece capture only flips a bit in the scratch slot.
+        m_pieces[move.toPiece] ^= toPos;
+
+        m_mailbox[move.fromIdx] = move.fromPiece;
+        m_mailbox[move.toIdx]   = move.toPiece;
+    }
+
+    m_numPieceArr[move.toPiece] += (move.toPiece != Piece::NoPiece) ? 1 : 0;
+}
+
+void Board::ResetMailbox()
 {
-    memcpy(&m_boardState, pBoardInfo, sizeof(BoardInfo));
-    memcpy(&(m_pieces[0]), pPieceData, sizeof(m_pieces));
+    for (uint32 idx = 0; idx < 64; idx++)
+    {
+        m_mailbox[idx] = Piece::NoPiece;
+    }
+
+    for (uint32 pieceIdx = 0; pieceIdx < Piece::NoPiece; pieceIdx++)
+    {
+        uint64 pieces = m_pieces[pieceIdx];
+        while (pieces != 0ull)
+        {
+            const uint64 pos = GetLSB(pieces);
+            pieces ^= pos;
+            m_mailbox[GetIndex(pos)] = static_cast<Piece>(pieceIdx);
+        }
+    }
 }
 
 std::string Board::GetStringFromMove(const Move& move)
 {
     std::string moveStr = "";
-    moveStr += GetRank(move.fromPos) + 'a';
-    moveStr += (7 - GetFile(move.fromPos)) + '1';
-    moveStr += GetRank(move.toPos) + 'a';
-    moveStr += (7 - GetFile(move.toPos)) + '1';
+    moveStr += GetRank(move.FromPos()) + 'a';
+    moveStr += (7 - GetFile(move.FromPos())) + '1';
+    moveStr += GetRank(move.ToPos()) + 'a';
+    moveStr += (7 - GetFile(move.ToPos())) + '1';
 
     if ((move.flags & CastleFlags) != 0)
     {
@@ -560,21 +870,29 @@ std::string Board::GetStringFromMove(const Move& move)
         }
     }
 
+    // Same suffix UCI uses
+    if      (move.flags == QueenPromotion)  { moveStr += 'q'; }
+    else if (move.flags == RookPromotion)   { moveStr += 'r'; }
+    else if (move.flags == BishopPromotion) { moveStr += 'b'; }
+    else if (move.flags == KnightPromotion) { moveStr += 'n'; }
+
     return moveStr;
 }
 
 template<bool isWhite>
 void Board::MakeNullMove()
 {
-    m_boardState.lastPosMoved    = 0ull;
-    m_boardState.lastPosCaptured = 0ull;
+    PushUndoEntry();
+
+    m_boardState.lastCaptureIdx = NoSquare;
     // Switch the team.
     m_boardState.zobristKey ^= m_ppZobristArray[0][65];
     m_boardState.isWhiteTurn = !m_boardState.isWhiteTurn;
 
     // These aren't valid anymore
-    m_boardState.checkAndPinMasksValid = false;
-    m_boardState.illegalKingMoveMask = false;
+    GetMasks().checkAndPinMasksValid = false;
+    GetMasks().illegalKingMovesValid = false;
+    InvalidateAttackInfo();
 
     // Take out EP zobrist
     if (m_boardState.enPassantSquare != 0ull)
@@ -589,34 +907,106 @@ void Board::MakeNullMove()
     nullMove.flags = 0xFF;
     UpdateLastIrreversableMove<isWhite>(nullMove);
     m_boardState.currMoveNum++;
+
+    if (m_pNnueNetwork != nullptr)
+    {
+        ApplyNnueDelta({});
+    }
 }
 
 template void Board::MakeNullMove<true>();
 template void Board::MakeNullMove<false>();
 
+// Called once the move is made, so a promotion finds the piece it promoted to in the mailbox.
+template<bool isWhite>
+void Board::UpdateNnueAccumulator(const Move& move)
+{
+    NnueDelta delta = {};
+
+    if ((move.flags & MoveFlags::CastleFlags) != 0)
+    {
+        constexpr Piece kingPiece = (isWhite) ? Piece::wKing : Piece::bKing;
+        constexpr Piece rookPiece = (isWhite) ? Piece::wRook : Piece::bRook;
+
+        // The rook lands on the square the king crosses.
+        const bool   isKingSide   = (move.flags & (WhiteKingCastle | BlackKingCastle)) != 0;
+        const uint32 rookStartIdx = (isKingSide) ? move.toIdx + 1 : move.toIdx - 2;
+        const uint32 rookLandIdx  = (isKingSide) ? move.toIdx - 1 : move.toIdx + 1;
+
+        delta.numAdded        = 2;
+        delta.addedPiece[0]   = kingPiece;
+        delta.addedIdx[0]     = move.toIdx;
+        delta.addedPiece[1]   = rookPiece;
+        delta.addedIdx[1]     = rookLandIdx;
+        delta.numRemoved      = 2;
+        delta.removedPiece[0] = kingPiece;
+        delta.removedIdx[0]   = move.fromIdx;
+        delta.removedPiece[1] = rookPiece;
+        delta.removedIdx[1]   = rookStartIdx;
+    }
+    else
+    {
+        delta.numAdded        = 1;
+        delta.addedPiece[0]   = m_mailbox[move.toIdx];
+        delta.addedIdx[0]     = move.toIdx;
+        delta.numRemoved      = 1;
+        delta.removedPiece[0] = move.fromPiece;
+        delta.removedIdx[0]   = move.fromIdx;
+
+        if (move.flags == MoveFlags::EnPassant)
+        {
+            delta.numRemoved      = 2;
+            delta.removedPiece[1] = (isWhite) ? Piece::bPawn : Piece::wPawn;
+            delta.removedIdx[1]   = (isWhite) ? move.toIdx - 8 : move.toIdx + 8;
+        }
+        else if (move.toPiece != Piece::NoPiece)
+        {
+            delta.numRemoved      = 2;
+            delta.removedPiece[1] = move.toPiece;
+            delta.removedIdx[1]   = move.toIdx;
+        }
+    }
+
+    ApplyNnueDelta(delta);
+}
+
+void Board::ApplyNnueDelta(const NnueDelta& delta)
+{
+    // The ply below is from before the last refresh, so there's nothing to update from.
+    if (m_undoStackSize <= m_nnueValidPly)
+    {
+        RefreshNnueAccumulator();
+        return;
+    }
+
+    m_pNnueNetwork->UpdateAccumulator(m_nnueAccumulators[m_undoStackSize - 1],
+                                      delta,
+                                      &GetNnueAccumulator());
+}
+
 template<bool isWhite>
 void Board::MakeNormalMove(const Move& move)
 {
     m_boardState.enPassantSquare = 0ull;
-    m_pieces[move.fromPiece] ^= (move.toPos | move.fromPos);
+    m_pieces[move.fromPiece] ^= (move.ToPos() | move.FromPos());
     if constexpr (isWhite)
     {
-        m_boardState.whitePieces ^= (move.toPos | move.fromPos);
-        m_boardState.blackPieces &= ~move.toPos;
+        m_boardState.whitePieces ^= (move.ToPos() | move.FromPos());
+        m_boardState.blackPieces &= ~move.ToPos();
     }
     else
     {
-        m_boardState.blackPieces ^= (move.toPos | move.fromPos);
-        m_boardState.whitePieces &= ~move.toPos;
+        m_boardState.blackPieces ^= (move.ToPos() | move.FromPos());
+        m_boardState.whitePieces &= ~move.ToPos();
     }
     UpdateEnPassantSquare<isWhite>(move);
     UpdateCastleFlags<isWhite>(move);
     // the Piece::NoPiece allows this to avoid needing a branch, since
     // it is just writing to a garbage data spot
-    m_pieces[move.toPiece] ^= move.toPos;
+    m_pieces[move.toPiece] ^= move.ToPos();
 
-    uint32 fromIdx = GetIndex(move.fromPos);
-    uint32 toIdx = GetIndex(move.toPos);
+    uint32 fromIdx = move.fromIdx;
+    uint32 toIdx = move.toIdx;
 
     m_boardState.zobristKey ^= m_ppZobristArray[move.fromPiece][fromIdx];
     m_boardState.zobristKey ^= m_ppZobristArray[move.fromPiece][toIdx];
@@ -626,7 +1016,15 @@ void Board::MakeNormalMove(const Move& move)
         m_boardState.zobristKey ^= m_ppZobristArray[move.toPiece][toIdx];
     }
 
-    m_boardState.allPieces = m_boardState.whitePieces | m_boardState.blackPieces;
+    m_mailbox[fromIdx] = Piece::NoPiece;
+    m_mailbox[toIdx]   = move.fromPiece;
+
+    m_boardState.pawnKey ^= PawnZobristTable.keys[move.fromPiece][fromIdx] ^
+                            PawnZobristTable.keys[move.fromPiece][toIdx]   ^
+                            PawnZobristTable.keys[move.toPiece][toIdx];
+
+    MovePieceSquareScore(move.fromPiece, fromIdx, toIdx);
+    RemovePieceSquareScore(move.toPiece, toIdx);
 }
 
 template<bool isWhite>
@@ -638,19 +1036,19 @@ void Board::UpdateCastleFlags(const Move& move)
     bool noBlackQueenside = false;
     if constexpr (isWhite)
     {
-        noWhiteKingside  = (move.fromPos == WhiteKingStart) || (move.fromPos == WhiteKingSideRookStart);
-        noWhiteQueenside = (move.fromPos == WhiteKingStart) || (move.fromPos == WhiteQueenSideRookStart);
+        noWhiteKingside  = (move.FromPos() == WhiteKingStart) || (move.FromPos() == WhiteKingSideRookStart);
+        noWhiteQueenside = (move.FromPos() == WhiteKingStart) || (move.FromPos() == WhiteQueenSideRookStart);
 
-        noBlackKingside  = (move.toPos == BlackKingSideRookStart);
-        noBlackQueenside = (move.toPos == BlackQueenSideRookStart);
+        noBlackKingside  = (move.ToPos() == BlackKingSideRookStart);
+        noBlackQueenside = (move.ToPos() == BlackQueenSideRookStart);
     }
     else
     {
-        noBlackKingside = (move.fromPos == BlackKingStart) || (move.fromPos == BlackKingSideRookStart);
-        noBlackQueenside = (move.fromPos == BlackKingStart) || (move.fromPos == BlackQueenSideRookStart);
+        noBlackKingside = (move.FromPos() == BlackKingStart) || (move.FromPos() == BlackKingSideRookStart);
+        noBlackQueenside = (move.FromPos() == BlackKingStart) || (move.FromPos() == BlackQueenSideRookStart);
 
-        noWhiteKingside = (move.toPos == WhiteKingSideRookStart);
-        noWhiteQueenside = (move.toPos == WhiteQueenSideRookStart);
+        noWhiteKingside = (move.ToPos() == WhiteKingSideRookStart);
+        noWhiteQueenside = (move.ToPos() == WhiteQueenSideRookStart);
     }
     uint32 removeCastleFlags = 0;
     removeCastleFlags |= (noWhiteKingside)  ? WhiteKingCastle  : 0;
@@ -749,43 +1147,60 @@ void Board::MakeCastleMove()
     m_boardState.zobristKey ^= m_ppZobristArray[rookPiece][rookStartIdx];
     m_boardState.zobristKey ^= m_ppZobristArray[rookPiece][rookLandIdx];
 
-    m_boardState.allPieces ^= (kingStart | kingLand | rookStart | rookLand);
+    m_mailbox[kingStartIdx] = Piece::NoPiece;
+    m_mailbox[rookStartIdx] = Piece::NoPiece;
+    m_mailbox[kingLandIdx]  = kingPiece;
+    m_mailbox[rookLandIdx]  = rookPiece;
+
+    MovePieceSquareScore(kingPiece, kingStartIdx, kingLandIdx);
+    MovePieceSquareScore(rookPiece, rookStartIdx, rookLandIdx);
+
     m_boardState.enPassantSquare = 0ull;
 }
 
 template<bool isWhite>
 void Board::MakeEnPassantMove(const Move& move)
 {
-    CH_ASSERT(move.toPos == m_boardState.enPassantSquare);
+    CH_ASSERT(move.ToPos() == m_boardState.enPassantSquare);
     constexpr Piece teamPawn     = (isWhite) ? Piece::wPawn : 
                                                Piece::bPawn;
     constexpr Piece enemyPawn    = (isWhite) ? Piece::bPawn :
                                                Piece::wPawn;
-    const uint64 enemySquare = (isWhite) ? MoveDown(move.toPos) :
-                                           MoveUp(move.toPos);
-    m_pieces[teamPawn]  ^= (move.fromPos | move.toPos);
+    const uint64 enemySquare = (isWhite) ? MoveDown(move.ToPos()) :
+                                           MoveUp(move.ToPos());
+    m_pieces[teamPawn]  ^= (move.FromPos() | move.ToPos());
     m_pieces[enemyPawn] ^= (enemySquare);
 
     if constexpr (isWhite)
     {
-        m_boardState.whitePieces ^= move.fromPos | move.toPos;
+        m_boardState.whitePieces ^= move.FromPos() | move.ToPos();
         m_boardState.blackPieces ^= enemySquare;
     }
     else
     {
-        m_boardState.blackPieces ^= move.fromPos | move.toPos;
+        m_boardState.blackPieces ^= move.FromPos() | move.ToPos();
         m_boardState.whitePieces ^= enemySquare;
     }
 
-    const int32 fromIdx  = GetIndex(move.fromPos);
-    const int32 toIdx    = GetIndex(move.toPos);
+    const int32 fromIdx  = move.fromIdx;
+    const int32 toIdx    = move.toIdx;
     const int32 enemyIdx = GetIndex(enemySquare);
 
     m_boardState.zobristKey ^= m_ppZobristArray[teamPawn][fromIdx];
     m_boardState.zobristKey ^= m_ppZobristArray[teamPawn][toIdx];
     m_boardState.zobristKey ^= m_ppZobristArray[enemyPawn][enemyIdx];
 
-    m_boardState.allPieces ^= (move.fromPos | move.toPos | enemySquare);
+    m_mailbox[fromIdx]  = Piece::NoPiece;
+    m_mailbox[enemyIdx] = Piece::NoPiece;
+    m_mailbox[toIdx]    = teamPawn;
+
+    m_boardState.pawnKey ^= PawnZobristTable.keys[teamPawn][fromIdx]  ^
+                            PawnZobristTable.keys[teamPawn][toIdx]    ^
+                            PawnZobristTable.keys[enemyPawn][enemyIdx];
+
+    MovePieceSquareScore(teamPawn, fromIdx, toIdx);
+    RemovePieceSquareScore(enemyPawn, enemyIdx);
+
     m_boardState.enPassantSquare = 0ull;
 }
 
@@ -795,18 +1210,18 @@ void Board::UpdateEnPassantSquare(const Move& move)
     if constexpr (isWhite)
     {
         if ((move.fromPiece == Piece::wPawn) &&
-            (move.toPos == MoveUp(MoveUp(move.fromPos))))
+            (move.ToPos() == MoveUp(MoveUp(move.FromPos()))))
         { 
-            m_boardState.enPassantSquare = MoveUp(move.fromPos);
+            m_boardState.enPassantSquare = MoveUp(move.FromPos());
             m_boardState.zobristKey ^= m_ppZobristArray[Piece::NoPiece][GetIndex(m_boardState.enPassantSquare)];
         }
     }
     else
     {
         if ((move.fromPiece == Piece::bPawn) &&
-            (move.toPos == MoveDown(MoveDown(move.fromPos))))
+            (move.ToPos() == MoveDown(MoveDown(move.FromPos()))))
         {
-            m_boardState.enPassantSquare = MoveDown(move.fromPos);
+            m_boardState.enPassantSquare = MoveDown(move.FromPos());
             m_boardState.zobristKey ^= m_ppZobristArray[Piece::NoPiece][GetIndex(m_boardState.enPassantSquare)];
         }
     }
@@ -815,15 +1230,15 @@ void Board::UpdateEnPassantSquare(const Move& move)
 template<bool isWhite>
 void Board::MakePromotionMove(const Move& move)
 {
-    int32 fromIdx = GetIndex(move.fromPos);
-    int32 toIdx   = GetIndex(move.toPos);
+    int32 fromIdx = move.fromIdx;
+    int32 toIdx   = move.toIdx;
 
     Piece promotionPiece = Piece::NoPiece;
     if constexpr (isWhite)
     {
-        m_pieces[Piece::wPawn] ^= move.fromPos;
-        m_boardState.whitePieces ^= (move.fromPos | move.toPos);
-        m_boardState.blackPieces &= (~move.toPos);
+        m_pieces[Piece::wPawn] ^= move.FromPos();
+        m_boardState.whitePieces ^= (move.FromPos() | move.ToPos());
+        m_boardState.blackPieces &= (~move.ToPos());
 
         m_boardState.zobristKey ^= m_ppZobristArray[Piece::wPawn][fromIdx];
 
@@ -847,9 +1262,9 @@ void Board::MakePromotionMove(const Move& move)
     }
     else
     {
-        m_pieces[Piece::bPawn] ^= move.fromPos;
-        m_boardState.blackPieces ^= (move.fromPos | move.toPos);
-        m_boardState.whitePieces &= (~move.toPos);
+        m_pieces[Piece::bPawn] ^= move.FromPos();
+        m_boardState.blackPieces ^= (move.FromPos() | move.ToPos());
+        m_boardState.whitePieces &= (~move.ToPos());
 
         m_boardState.zobristKey ^= m_ppZobristArray[Piece::bPawn][fromIdx];
 
@@ -872,21 +1287,36 @@ void Board::MakePromotionMove(const Move& move)
         }
     }
 
-    m_pieces[promotionPiece] |= move.toPos;
+    m_pieces[promotionPiece] |= move.ToPos();
     m_boardState.zobristKey ^= m_ppZobristArray[promotionPiece][toIdx];
 
+    m_mailbox[fromIdx] = Piece::NoPiece;
+    m_mailbox[toIdx]   = promotionPiece;
+
+    m_boardState.pawnKey ^= PawnZobristTable.keys[move.fromPiece][fromIdx] ^
+                            PawnZobristTable.keys[move.toPiece][toIdx];
+
     m_boardState.pieceValueScore -= PieceValueArray[move.fromPiece];
     m_boardState.pieceValueScore += PieceValueArray[promotionPiece];
 
+    // %6 for the white value, the same as a capture takes off.
+    m_boardState.totalMaterialValue += PieceValueArray[promotionPiece % 6] - PieceScores::PawnScore;
+
+    m_numPieceArr[move.fromPiece]  -= 1;
+    m_numPieceArr[promotionPiece] += 1;
+
+    RemovePieceSquareScore(move.fromPiece, fromIdx);
+    RemovePieceSquareScore(move.toPiece, toIdx);
+    AddPieceSquareScore(promotionPiece, toIdx);
+
     UpdateCastleFlags<isWhite>(move);
-    m_pieces[move.toPiece] ^= move.toPos;
+    m_pieces[move.toPiece] ^= move.ToPos();
 
     if (move.toPiece != Piece::NoPiece)
     {
         m_boardState.zobristKey ^= m_ppZobristArray[move.toPiece][toIdx];
     }
 
-    m_boardState.allPieces = m_boardState.whitePieces | m_boardState.blackPieces;
     m_boardState.enPassantSquare = 0;
 }
 
@@ -969,6 +1399,16 @@ void Board::ResetZobKey()
     m_boardState.zobristKey = key;
 }
 
+void Board::ResetPawnKey()
+{
+    uint64 key = 0ull;
+    for (uint32 idx = 0; idx < 64; idx++)
+    {
+        key ^= PawnZobristTable.keys[m_mailbox[idx]][idx];
+    }
+    m_boardState.pawnKey = key;
+}
+
 void Board::ResetPieceScore()
 {
     int32 whiteMaterial = 0;
@@ -994,12 +1434,19 @@ void Board::ResetPieceScore()
             }
         }
 
-        m_boardState.numPieceArr[pieceIdx] = count;
+        m_numPieceArr[pieceIdx] = count;
     }
 
     // black material value is already negative here
-    m_boardState.pieceValueScore    = whiteMaterial + blackMaterial;
-    m_boardState.totalMaterialValue = whiteMaterial - blackMaterial;
+    m_boardState.pieceValueScore    = static_cast<int16>(whiteMaterial + blackMaterial);
+    m_boardState.totalMaterialValue = static_cast<int16>(whiteMaterial - blackMaterial);
+
+    m_boardState.midgamePieceSquareScore = 0;
+    m_boardState.endgamePieceSquareScore = 0;
+    for (uint32 idx = 0; idx < 64; idx++)
+    {
+        AddPieceSquareScore(m_mailbox[idx], idx);
+    }
 }
 
 // Updates last irreversable ply if our move is irreversable.  Also returns the previous ply to make
@@ -1025,7 +1472,7 @@ void Board::UpdateLastIrreversableMove(const Move& move)
 
     if (isMoveIrreversable)
     {
-        m_boardState.lastIrreversableMoveNum = insertNum;
+        m_boardState.lastIrreversableMoveNum = static_cast<uint16>(insertNum);
     }
 
     CH_ASSERT(insertNum < 1024);
@@ -1072,65 +1519,138 @@ template bool Board::IsDrawByRepetition<true>();
 template bool Board::IsDrawByRepetition<false>();
 
 template<bool isWhite>
-int32 Board::ScoreBoard()
+int32 Board::ScoreBoard() const
 {
-    // This could be optimized to only copy/restore what's absolutley necessary...
-    BoardInfo boardStateCopy = m_boardState;
-    InvalidateCheckPinAndIllegalMoves();
+    bool lazyExit = false;
+    return ScoreBoard<isWhite>(INT32_MIN, INT32_MAX, 0, &lazyExit);
+}
 
-    int32 score = m_boardState.pieceValueScore;
+template<bool isWhite>
+int32 Board::ScoreBoard(int32 alpha, int32 beta, int32 lazyMargin, bool* pLazyExit) const
+{
+    constexpr int32 multFactor = (isWhite) ? 1 : -1;
 
-    uint64 whiteSliderSquares = GetSliderSeenSquares<true>(FullBoard);
-    uint64 whiteMoveSquares   = GetPawnKnightKingSeenSquares<true>();
-    uint64 whiteMoves         = whiteSliderSquares | whiteMoveSquares;
+    // Without queens rooks or pawns, this is probably a drawn game
+    const bool probablyDraw = (GetQueen<true>() | GetQueen<false>() |
+                               GetRook<true>()  | GetRook<false>()  |
+                               GetPawn<true>()  | GetPawn<false>()) == 0ull;
 
-    uint64 blackSliderSquares = GetSliderSeenSquares<false>(FullBoard);
-    uint64 blackMoveSquares   = GetPawnKnightKingSeenSquares<false>();
-    uint64 blackMoves         = blackSliderSquares | blackMoveSquares;
-    
+    // Everything that's kept up incrementally or looked up, before the attack maps.
+    int32 score = m_boardState.pieceValueScore + GetPieceSquareScore();
 
-    score += GetKingSafteyScore(whiteMoves, blackMoves);
     score += GetPawnBonusScores();
     score += GetRookBonusScores();
     score += GetKnightBonusScores();
 
+    // King safety and mobility only move the score by lazyMargin at most, so if the rest of it is
+    // further than that outside the window, the full score would be too.  The bounds are rounded
+    // the same way the score is at the end.
+    if (probablyDraw == false)
+    {
+        const int32 lazyScore = score * multFactor;
+        *pLazyExit = (((lazyScore - lazyMargin) & ~0xF) >= beta) ||
+                     (((lazyScore + lazyMargin) & ~0xF) <  alpha);
+        if (*pLazyExit)
+        {
+            return lazyScore & ~0xF;
+        }
+    }
+    *pLazyExit = false;
+
+    // Move generation at this node may have already filled in one side.  Whatever is missing is
+    // worked out into a copy, so scoring never writes to the board.
+    AttackInfo attackInfo = m_attackInfo[m_undoStackSize];
+    FillAttackInfo<true>(&attackInfo);
+    FillAttackInfo<false>(&attackInfo);
+    const uint64      whiteMoves = attackInfo.attacks[GetAttackSide(true)];
+    const uint64      blackMoves = attackInfo.attacks[GetAttackSide(false)];
+
+    score += GetKingSafteyScore(attackInfo);
+
     int32 whiteMobilityScore = GeneralMobilityScore * (PopCount(GetWhitePieces() & whiteMoves));
     int32 blackMobilityScore = GeneralMobilityScore * (PopCount(GetBlackPieces() & blackMoves));
 
     score += (whiteMobilityScore - blackMobilityScore);
 
-    constexpr int32 multFactor = (isWhite) ? 1 : -1;
     score *= multFactor;
 
-
-    // Without queens rooks or pawns, this is probably a drawn game
-    const bool probablyDraw = (GetQueen<true>() | GetQueen<false>() |
-                               GetRook<true>()  | GetRook<false>()  |
-                               GetPawn<true>()  | GetPawn<false>()) == 0ull;
     if (probablyDraw)
     {
         score /= 10;
     }
 
-    m_boardState = boardStateCopy;
-
     // drop the low 4 bits, helps TT
     score &= ~0xF;
     return score;
 }
 
-int32 Board::GetKingSafteyScore(uint64 whiteSeenSquares, uint64 blackSeenSquares)
+void Board::SetNnueNetwork(const NnueNetwork* pNetwork)
 {
+    m_pNnueNetwork = pNetwork;
+    if (m_pNnueNetwork == nullptr)
+    {
+        m_nnueAccumulators.clear();
+        m_nnueAccumulators.shrink_to_fit();
+        return;
+    }
+
+    m_nnueAccumulators.resize(MaxUndoStackSize + 1);
+    RefreshNnueAccumulator();
+}
+
+void Board::RefreshNnueAccumulator()
+{
+    m_pNnueNetwork->RefreshAccumulator(reinterpret_cast<const uint8*>(&(m_mailbox[0])),
+                                       &GetNnueAccumulator());
+    m_nnueValidPly = m_undoStackSize;
+}
+
+template<bool isWhite>
+int32 Board::EvaluateNnue()
+{
+    CH_ASSERT(m_pNnueNetwork != nullptr);
+    CH_ASSERT(m_boardState.isWhiteTurn == isWhite);
+
+    if (m_undoStackSize < m_nnueValidPly)
+    {
+        RefreshNnueAccumulator();
+    }
+    return m_pNnueNetwork->Evaluate(GetNnueAccumulator(), isWhite);
+}
+
+template int32 Board::EvaluateNnue<true>();
+template int32 Board::EvaluateNnue<false>();
+
+// Blends the midgame and endgame piece square scores by how much material is left.
+int32 Board::GetPieceSquareScore() const
+{
+    const int32 materialAboveEndgame = m_boardState.totalMaterialValue - EndgameMaterialValue;
+    const int32 phase = std::clamp<int32>(
+        (materialAboveEndgame * MaxGamePhase) / (OpeningMaterialValue - EndgameMaterialValue),
+        0,
+        MaxGamePhase);
+
+    return ((m_boardState.midgamePieceSquareScore * phase) +
+            (m_boardState.endgamePieceSquareScore * (MaxGamePhase - phase))) / MaxGamePhase;
+}
+
+// Only castled kings get these terms.
+int32 Board::GetKingSafteyScore(const AttackInfo& attackInfo) const
+{
+    // Attacks on the squares next to each king, by the other side.
+    const uint64 whiteKingZoneAttacks = attackInfo.kingZoneAttacks[GetAttackSide(false)];
+    const uint64 blackKingZoneAttacks = attackInfo.kingZoneAttacks[GetAttackSide(true)];
+
     // white king
     int32 whiteKingScore = 0;
     uint64 whiteKingPos = (GetKing<true>() & (WhiteKingSideCastleLand | WhiteQueenSideCastleLand));
 
-    uint64 whiteKingMoves = GetKingMoves<true, true>(whiteKingPos);
+    uint64 whiteKingMoves = GetKingAttacks(whiteKingPos);
 
     uint64 whiteKingTouchingPawns = whiteKingMoves & GetPawn<true>();
     whiteKingScore += PawnOneAwayFromCastledKing * PopCount(whiteKingTouchingPawns);
     whiteKingScore += PawnTwoAwayFromCastledKing * PopCount(MoveUp(whiteKingMoves) & ~whiteKingTouchingPawns);
-    whiteKingScore += CutoffKingMoveScore        * PopCount(whiteKingMoves & blackSeenSquares);
+    whiteKingScore += CutoffKingMoveScore        * PopCount(whiteKingMoves & whiteKingZoneAttacks);
     whiteKingScore += NormalPieceTouchingKing    * PopCount(whiteKingMoves & GetWhitePieces());
 
 
@@ -1138,18 +1658,18 @@ int32 Board::GetKingSafteyScore(uint64 whiteSeenSquares, uint64 blackSeenSquares
     int32 blackKingScore = 0;
     uint64 blackKingPos = (GetKing<false>() & (BlackKingSideCastleLand | BlackQueenSideCastleLand));
 
-    uint64 blackKingMoves = GetKingMoves<false, true>(blackKingPos);
+    uint64 blackKingMoves = GetKingAttacks(blackKingPos);
 
     uint64 blackKingTouchingPawns = blackKingMoves & GetPawn<false>();
     blackKingScore += PawnOneAwayFromCastledKing * PopCount(blackKingTouchingPawns);
     blackKingScore += PawnTwoAwayFromCastledKing * PopCount(MoveUp(blackKingMoves) & ~blackKingTouchingPawns);
-    blackKingScore += CutoffKingMoveScore        * PopCount(blackKingMoves & whiteSeenSquares);
+    blackKingScore += CutoffKingMoveScore        * PopCount(blackKingMoves & blackKingZoneAttacks);
     blackKingScore += NormalPieceTouchingKing    * PopCount(blackKingMoves & GetWhitePieces());
 
     return whiteKingScore - blackKingScore;
 }
 
-int32 Board::GetPawnBonusScores()
+int32 Board::GetPawnBonusScores() const
 {
     int32 endMultiplier   = 1;
     int32 earlyMultiplier = 2;
@@ -1161,6 +1681,29 @@ int32 Board::GetPawnBonusScores()
         earlyMultiplier = 1;
     }
 
+    PawnHashEntry pawnEntry;
+    if (m_pPawnHashTable != nullptr)
+    {
+        PawnHashEntry* pTableEntry = m_pPawnHashTable->GetEntry(m_boardState.pawnKey);
+        const bool     hit         = (pTableEntry->pawnKey == m_boardState.pawnKey);
+        if (hit == false)
+        {
+            EvaluatePawnStructure(pTableEntry);
+        }
+        m_pPawnHashTable->CountProbe(hit);
+        pawnEntry = *pTableEntry;
+    }
+    else
+    {
+        EvaluatePawnStructure(&pawnEntry);
+    }
+
+    return (pawnEntry.structureScore * earlyMultiplier) + (pawnEntry.passedPawnScore * endMultiplier);
+}
+
+// Everything in the pawn terms that only depends on the pawns, so it can go in the pawn hash table.
+void Board::EvaluatePawnStructure(PawnHashEntry* pEntry) const
+{
     int32 whiteScore = 0;
     uint64 whitePawns = GetPawn<true>();
     uint64 whitePawnsDefendingPawns = (MoveUpRight(whitePawns) | (MoveUpLeft(whitePawns))) & whitePawns;
@@ -1177,9 +1720,6 @@ int32 Board::GetPawnBonusScores()
     blackScore += PawnChainScore   * PopCount(blackPawnsDefendingPawns);
     blackScore += DoubledPawnScore * PopCount(blackDoubledPawns);
 
-    whiteScore *= earlyMultiplier;
-    blackScore *= earlyMultiplier;
-
     uint64 whitePawnKillMask = whitePawns | MoveLeft(whitePawns) | MoveRight(whitePawns);
     uint64 blackPawnKillMask = blackPawns | MoveLeft(blackPawns) | MoveRight(blackPawns);
 
@@ -1209,47 +1749,37 @@ int32 Board::GetPawnBonusScores()
         blackEndScore += ClosePassedPawnScore * PopCount(blackPassedPawns & (Rank3 | Rank2));
     }
 
-    whiteEndScore += FarPawnAdvanceScore   * PopCount(whitePawns & (Rank2 | Rank3));
-    whiteEndScore += MidPawnAdvanceScore   * PopCount(whitePawns & (Rank4 | Rank5));
-    whiteEndScore += ClosePawnAdvanceScore * PopCount(whitePawns & (Rank6 | Rank7));
-
-    blackEndScore += FarPawnAdvanceScore   * PopCount(blackPawns & (Rank7 | Rank6));
-    blackEndScore += MidPawnAdvanceScore   * PopCount(blackPawns & (Rank5 | Rank4));
-    blackEndScore += ClosePawnAdvanceScore * PopCount(blackPawns & (Rank3 | Rank2));
-
-    whiteEndScore *= endMultiplier;
-    blackEndScore *= endMultiplier;
-
-    whiteScore += whiteEndScore;
-    blackScore += blackEndScore;
-
-    return whiteScore - blackScore;
+    pEntry->pawnKey          = m_boardState.pawnKey;
+    pEntry->whitePassedPawns = whitePassedPawns;
+    pEntry->blackPassedPawns = blackPassedPawns;
+    pEntry->structureScore   = static_cast<int16>(whiteScore - blackScore);
+    pEntry->passedPawnScore  = static_cast<int16>(whiteEndScore - blackEndScore);
 }
 
 
 // I should add open files
-int32 Board::GetRookBonusScores()
+int32 Board::GetRookBonusScores() const
 {
-    uint32 numWhitePawns = m_boardState.numPieceArr[wPawn];
-    uint32 numBlackPawns = m_boardState.numPieceArr[bPawn];
-    int32 whiteScore = m_boardState.numPieceArr[wRook] * RookAdjustmentScores[numWhitePawns];
-    int32 blackScore = m_boardState.numPieceArr[bRook] * RookAdjustmentScores[numBlackPawns];
+    uint32 numWhitePawns = m_numPieceArr[wPawn];
+    uint32 numBlackPawns = m_numPieceArr[bPawn];
+    int32 whiteScore = m_numPieceArr[wRook] * RookAdjustmentScores[numWhitePawns];
+    int32 blackScore = m_numPieceArr[bRook] * RookAdjustmentScores[numBlackPawns];
 
     return whiteScore - blackScore;
 }
 
-int32 Board::GetKnightBonusScores()
+int32 Board::GetKnightBonusScores() const
 {
-    uint32 numWhitePawns = m_boardState.numPieceArr[wPawn];
-    uint32 numBlackPawns = m_boardState.numPieceArr[bPawn];
-    int32 whiteScore = m_boardState.numPieceArr[wKnight] * KnightAdjustmentScores[numWhitePawns];
-    int32 blackScore = m_boardState.numPieceArr[bKnight] * KnightAdjustmentScores[numBlackPawns];
+    uint32 numWhitePawns = m_numPieceArr[wPawn];
+    uint32 numBlackPawns = m_numPieceArr[bPawn];
+    int32 whiteScore = m_numPieceArr[wKnight] * KnightAdjustmentScores[numWhitePawns];
+    int32 blackScore = m_numPieceArr[bKnight] * KnightAdjustmentScores[numBlackPawns];
 
     return whiteScore - blackScore;
 }
 
 // This will give extra points for being aggressive with our king in the endgame
-int32 Board::AggressiveKingEndgameBonus()
+int32 Board::AggressiveKingEndgameBonus() const
 {
     int32 whiteBonus = 0;
     int32 blackBonus = 0;
@@ -1284,5 +1814,7 @@ int32 Board::AggressiveKingEndgameBonus()
     return whiteBonus - blackBonus;
 }
 
-template int32 Board::ScoreBoard<true>();
-template int32 Board::ScoreBoard<false>();
\ No newline at end of file
+template int32 Board::ScoreBoard<true>() const;
+template int32 Board::ScoreBoard<false>() const;
+template int32 Board::ScoreBoard<true>(int32 alpha, int32 beta, int32 lazyMargin, bool* pLazyExit) const;
+template int32 Board::ScoreBoard<false>(int32 alpha, int32 beta, int32 lazyMargin, bool* pLazyExit) const;
\ No newline at end of file
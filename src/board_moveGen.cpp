@@ -1,6 +1,10 @@
 #include "../inc/board.h"
 #include "../inc/bitHelper.h"
 #include "../inc/engine.h"
+#include "../inc/sliderAttacks.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
 
 // This file is the implementation of the move generation functions for the Board class.  It is a
 // Separate function because there is quite a bit that goes into it.
@@ -33,12 +37,9 @@ void Board::GetCheckmaskAndPinsInDirection(uint64 pos)
     }
 
     const uint64 endOfRayIdx = GetIndex(endOfRay);
-    // If there was no piece putting the king under attack, cutoffRay should just be set to mask
-    // out the whole ray.
+    // If there was no piece putting the king under attack, there is no ray to the enemy slider.
     const bool rayIsZero = endOfRay == 0ull;
-    const uint64 cutoffRay = (rayIsZero) ? ray : m_pRayTable[dir][endOfRayIdx];
-
-    const uint64 rayToEnemySlider = ray & ~cutoffRay;
+    const uint64 rayToEnemySlider = (rayIsZero) ? 0ull : RayToSquareTable[posIdx][endOfRayIdx];
 
     // numPiecesInRay will be:
     //  0  -- no enemy slider looking in the direction of our king, nothing to do
@@ -46,11 +47,11 @@ void Board::GetCheckmaskAndPinsInDirection(uint64 pos)
     //  2  -- enemy slider pinning a piece to our king
     //  3  -- 2 pieces pinned together.  Only relevant for checking en passant legality
     //  >3 -- Nothing to do.
-    const uint32 numPiecesInRay = PopCount(rayToEnemySlider & m_boardState.allPieces);
+    const uint32 numPiecesInRay = PopCount(rayToEnemySlider & GetAllPieces());
 
     // Now set the appropriate masks
-    m_boardState.checkMask |= (numPiecesInRay == 1) ? rayToEnemySlider : 0ull;
-    m_boardState.numPiecesChecking += (numPiecesInRay == 1);
+    GetMasks().checkMask |= (numPiecesInRay == 1) ? rayToEnemySlider : 0ull;
+    GetMasks().numPiecesChecking += (numPiecesInRay == 1);
 
     // This will help prune king moves by eliminating checks that go through the king.  This should
     // only be a single instruction because dir is templated.
@@ -62,24 +63,24 @@ void Board::GetCheckmaskAndPinsInDirection(uint64 pos)
                              (dir == NorthWest) ? MoveDownRight(pos) :
                              (dir == SouthEast) ? MoveUpLeft(pos)    :
                                                   MoveUpRight(pos);
-    m_boardState.kingXRayMoveMask |= (numPiecesInRay == 1) ? squareBehindRay : 0ull;
+    GetMasks().kingXRayMoveMask |= (numPiecesInRay == 1) ? squareBehindRay : 0ull;
 
     if constexpr (isHV)
     {
-        m_boardState.hvPinMask       |= (numPiecesInRay == 2) ? rayToEnemySlider : 0ull;
+        GetMasks().hvPinMask       |= (numPiecesInRay == 2) ? rayToEnemySlider : 0ull;
     }
     else
     {
-        m_boardState.diagPinMask |= (numPiecesInRay == 2) ? rayToEnemySlider : 0ull;
+        GetMasks().diagPinMask |= (numPiecesInRay == 2) ? rayToEnemySlider : 0ull;
     }
     if constexpr ((dir == East) || (dir == West))
     {
-        m_boardState.doubleHorizontalPinMask |= (numPiecesInRay == 3) ? rayToEnemySlider : 0ull;
+        GetMasks().doubleHorizontalPinMask |= (numPiecesInRay == 3) ? rayToEnemySlider : 0ull;
     }
 }
 
 template<Directions dir>
-uint64 Board::CastRayToBlocker(uint64 pos, uint64 mask)
+uint64 Board::CastRayToBlocker(uint64 pos, uint64 mask) const
 {
     constexpr bool needLsb = ((dir == North) || (dir == East) || 
                               (dir == NorthEast) || (dir == NorthWest));
@@ -104,40 +105,166 @@ uint64 Board::CastRayToBlocker(uint64 pos, uint64 mask)
     return (noCutoff) ? ray : ray ^ m_pRayTable[dir][endOfRayIdx];
 }
 
+template<SliderBackend backend>
+uint64 Board::GetRookAttacksWithBackend(uint64 pos, uint64 occupied) const
+{
+    if constexpr (backend == SliderBackend::Pext)
+    {
+        return GetRookAttacksPext(GetIndex(pos), occupied);
+    }
+    else if constexpr (backend == SliderBackend::Magic)
+    {
+        return GetRookAttacksMagic(GetIndex(pos), occupied);
+    }
+    else
+    {
+        return CastRayToBlocker<North>(pos, occupied) |
+               CastRayToBlocker<East>(pos, occupied)  |
+               CastRayToBlocker<South>(pos, occupied) |
+               CastRayToBlocker<West>(pos, occupied);
+    }
+}
+
+template<SliderBackend backend>
+uint64 Board::GetBishopAttacksWithBackend(uint64 pos, uint64 occupied) const
+{
+    if constexpr (backend == SliderBackend::Pext)
+    {
+        return GetBishopAttacksPext(GetIndex(pos), occupied);
+    }
+    else if constexpr (backend == SliderBackend::Magic)
+    {
+        return GetBishopAttacksMagic(GetIndex(pos), occupied);
+    }
+    else
+    {
+        return CastRayToBlocker<NorthEast>(pos, occupied) |
+               CastRayToBlocker<NorthWest>(pos, occupied) |
+               CastRayToBlocker<SouthEast>(pos, occupied) |
+               CastRayToBlocker<SouthWest>(pos, occupied);
+    }
+}
+
+template<SliderBackend backend>
+uint64 Board::GetRookAttacks(uint64 pos) const
+{
+    return GetRookAttacksWithBackend<backend>(pos, GetAllPieces());
+}
+
+template<SliderBackend backend>
+uint64 Board::GetBishopAttacks(uint64 pos) const
+{
+    return GetBishopAttacksWithBackend<backend>(pos, GetAllPieces());
+}
+
+static volatile uint64 SliderTimingSink = 0ull;
+
+// Times a fixed set of rook and bishop lookups on pseudo-random boards.  The results get xor'd
+// into pSink so the lookups can't be optimized out.
+template<SliderBackend backend>
+uint64 Board::TimeSliderBackend(uint64* pSink)
+{
+    constexpr uint32 NumLookups = 0x10000;
+
+    uint64 sink     = 0ull;
+    uint64 occupied = 0x9E3779B97F4A7C15ull;
+
+    auto startTime = std::chrono::steady_clock::now();
+    for (uint32 idx = 0; idx < NumLookups; idx++)
+    {
+        // xorshift, and'd with itself so about 1/4 of the board is occupied
+        occupied ^= occupied << 13;
+        occupied ^= occupied >> 7;
+        occupied ^= occupied << 17;
+
+        const uint64 pos = IndexToPosition(idx % 64);
+        sink ^= GetRookAttacksWithBackend<backend>(pos, occupied & (occupied >> 1));
+        sink ^= GetBishopAttacksWithBackend<backend>(pos, occupied & (occupied >> 1));
+    }
+    auto endTime = std::chrono::steady_clock::now();
+
+    *pSink ^= sink;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+// Picks the fastest slider backend this cpu supports.  Each one is timed a few times and the best
+// run is kept, so a single interrupted run doesn't decide it.
+void Board::SelectSliderBackend()
+{
+    static std::once_flag backendSelectFlag;
+    std::call_once(backendSelectFlag, [this]()
+    {
+        constexpr uint32 NumRuns = 3;
+
+        uint64 sink      = 0ull;
+        uint64 rayTime   = UINT64_MAX;
+        uint64 magicTime = UINT64_MAX;
+        uint64 pextTime  = UINT64_MAX;
+
+        const bool hasPext = CpuHasFastPext();
+        for (uint32 run = 0; run < NumRuns; run++)
+        {
+            rayTime   = std::min(rayTime,   TimeSliderBackend<SliderBackend::Ray>(&sink));
+            magicTime = std::min(magicTime, TimeSliderBackend<SliderBackend::Magic>(&sink));
+            if (hasPext)
+            {
+                pextTime = std::min(pextTime, TimeSliderBackend<SliderBackend::Pext>(&sink));
+            }
+        }
+
+        ActiveSliderBackend = (magicTime < rayTime) ? SliderBackend::Magic : SliderBackend::Ray;
+        if (pextTime < std::min(magicTime, rayTime))
+        {
+            ActiveSliderBackend = SliderBackend::Pext;
+        }
+
+        std::cout << "Slider attacks: " << GetSliderBackendName(ActiveSliderBackend);
+        std::cout << " (ray " << rayTime / 1000 << " us, magic " << magicTime / 1000 << " us";
+        if (hasPext)
+        {
+            std::cout << ", pext " << pextTime / 1000 << " us";
+        }
+        std::cout << ")" << std::endl;
+
+        // Keeps the timing loops from being optimized away.
+        SliderTimingSink = sink;
+    });
+}
+
 // This will generate a mask of all moves to get us out of check, and all pins to the king
 template<bool isWhite>
 void Board::GenerateCheckAndPinMask()
 {
     // If these are already valid, no need to re-compute
-    if (m_boardState.checkAndPinMasksValid == true)
+    if (GetMasks().checkAndPinMasksValid == true)
     {
         return;
     }
     const uint64 kingPos = GetKing<isWhite>();
-    m_boardState.checkMask               = 0ull;
-    m_boardState.hvPinMask               = 0ull;
-    m_boardState.diagPinMask             = 0ull;
-    m_boardState.doubleHorizontalPinMask = 0ull;
-    m_boardState.kingXRayMoveMask        = 0ull;
-    m_boardState.numPiecesChecking       = 0ull;
-    m_boardState.legalCastles            = 0ull;
+    GetMasks().checkMask               = 0ull;
+    GetMasks().hvPinMask               = 0ull;
+    GetMasks().diagPinMask             = 0ull;
+    GetMasks().doubleHorizontalPinMask = 0ull;
+    GetMasks().kingXRayMoveMask        = 0ull;
+    GetMasks().numPiecesChecking       = 0ull;
+    GetMasks().legalCastles            = 0ull;
 
     // If we are in check by a knight
-    m_boardState.checkMask = GetKnightMoves<isWhite, true>(kingPos) & GetKnight<!isWhite>();
+    GetMasks().checkMask = GetKnightMoves<isWhite, true>(kingPos) & GetKnight<!isWhite>();
 
     // If we are in check by a pawn.
     if constexpr (isWhite)
     {
-        m_boardState.checkMask |= (MoveUpRight(kingPos) | MoveUpLeft(kingPos))     & GetPawn<!isWhite>();
+        GetMasks().checkMask |= (MoveUpRight(kingPos) | MoveUpLeft(kingPos))     & GetPawn<!isWhite>();
     }
     else
     {
-        m_boardState.checkMask |= (MoveDownRight(kingPos) | MoveDownLeft(kingPos)) & GetPawn<!isWhite>();
+        GetMasks().checkMask |= (MoveDownRight(kingPos) | MoveDownLeft(kingPos)) & GetPawn<!isWhite>();
     }
 
     // We can never be checked by a pawn and knight at the same time, so increment the number of
     // pieces checking by 1 if we're checked by either.
-    m_boardState.numPiecesChecking += (m_boardState.checkMask != 0ull);
+    GetMasks().numPiecesChecking += (GetMasks().checkMask != 0ull);
 
     GetCheckmaskAndPinsInDirection<North,     isWhite>(kingPos);
     GetCheckmaskAndPinsInDirection<East,      isWhite>(kingPos);
@@ -149,9 +276,9 @@ void Board::GenerateCheckAndPinMask()
     GetCheckmaskAndPinsInDirection<SouthWest, isWhite>(kingPos);
 
     // If nobody is checking us, we can move anywhere.
-    m_boardState.checkMask = (m_boardState.checkMask == 0ull) ? FullBoard : m_boardState.checkMask;
+    GetMasks().checkMask = (GetMasks().checkMask == 0ull) ? FullBoard : GetMasks().checkMask;
 
-    m_boardState.checkAndPinMasksValid = true;
+    GetMasks().checkAndPinMasksValid = true;
 }
 
 template void Board::GenerateCheckAndPinMask<true>();
@@ -163,7 +290,7 @@ template<bool isWhite, bool printReason>
 bool Board::IsMoveLegal(const Move& move)
 {
     bool isLegal = true;
-    if (IsWhite(move.fromPos))
+    if (IsWhite(move.FromPos()))
     {
         GenerateCheckAndPinMask<true>();
         if (isWhite == false)
@@ -189,7 +316,7 @@ bool Board::IsMoveLegal(const Move& move)
     }
 
     // Are the pieces in the right spot
-    if ((m_pieces[move.fromPiece] & move.fromPos) == 0ull)
+    if (m_mailbox[move.fromIdx] != move.fromPiece)
     {
         isLegal = false;
         if constexpr (printReason)
@@ -197,9 +324,9 @@ bool Board::IsMoveLegal(const Move& move)
             std::cout << "Illegal fromPiece is not on fromPos" << std::endl;
         }
     }
-    if (((m_pieces[move.toPiece] & move.toPos) == 0ull) && 
-         (move.toPiece != Piece::NoPiece)               && 
-         (move.flags != MoveFlags::EnPassant))
+    // Also catches a quiet killer whose square has since been filled, which the old bitboard test
+    // let through because m_pieces[NoPiece] is only a scratch slot.
+    if ((m_mailbox[move.toIdx] != move.toPiece) && (move.flags != MoveFlags::EnPassant))
     {
         isLegal = false;
         if constexpr (printReason)
@@ -209,7 +336,7 @@ bool Board::IsMoveLegal(const Move& move)
     }
 
     // If it's en passant, can we do that
-    if ((move.flags == MoveFlags::EnPassant) && (move.toPos != m_boardState.enPassantSquare))
+    if ((move.flags == MoveFlags::EnPassant) && (move.ToPos() != m_boardState.enPassantSquare))
     {
         isLegal = false;
         if constexpr (printReason)
@@ -229,7 +356,7 @@ bool Board::IsMoveLegal(const Move& move)
     }
 
     // If we are in double check, only the king can be moved.
-    if ((m_boardState.numPiecesChecking > 1) && ((GetKing<isWhite>() & move.fromPos) == 0ull))
+    if ((GetMasks().numPiecesChecking > 1) && ((GetKing<isWhite>() & move.FromPos()) == 0ull))
     {
         isLegal = false;
         if constexpr (printReason)
@@ -245,41 +372,41 @@ bool Board::IsMoveLegal(const Move& move)
         switch (move.fromPiece)
         {
             case(wKing):
-                moves = GetKingMoves<true, false>(move.fromPos);
+                moves = GetKingMoves<true, false>(move.FromPos());
                 break;
             case(wQueen):
-                moves = GetQueenMoves<true, false>(move.fromPos);
+                moves = GetSliderMoves<wQueen, true>(move.FromPos());
                 break;
             case(wRook):
-                moves = GetRookMoves<true, false>(move.fromPos);
+                moves = GetSliderMoves<wRook, true>(move.FromPos());
                 break;
             case(wBishop):
-                moves = GetBishopMoves<true, false>(move.fromPos);
+                moves = GetSliderMoves<wBishop, true>(move.FromPos());
                 break;
             case(wKnight):
-                moves = GetKnightMoves<true, false>(move.fromPos);
+                moves = GetKnightMoves<true, false>(move.FromPos());
                 break;
             case(wPawn):
-                moves = GetPawnMoves<true, false>(move.fromPos);
+                moves = GetPawnMoves<true, false>(move.FromPos());
                 break;
 
             case(bKing):
-                moves = GetKingMoves<false, false>(move.fromPos);
+                moves = GetKingMoves<false, false>(move.FromPos());
                 break;
             case(bQueen):
-                moves = GetQueenMoves<false, false>(move.fromPos);
+                moves = GetSliderMoves<wQueen, false>(move.FromPos());
                 break;
             case(bRook):
-                moves = GetRookMoves<false, false>(move.fromPos);
+                moves = GetSliderMoves<wRook, false>(move.FromPos());
                 break;
             case(bBishop):
-                moves = GetBishopMoves<false, false>(move.fromPos);
+                moves = GetSliderMoves<wBishop, false>(move.FromPos());
                 break;
             case(bKnight):
-                moves = GetKnightMoves<false, false>(move.fromPos);
+                moves = GetKnightMoves<false, false>(move.FromPos());
                 break;
             case(bPawn):
-                moves = GetPawnMoves<false, false>(move.fromPos);
+                moves = GetPawnMoves<false, false>(move.FromPos());
                 break;
             default:
                 moves = 0ull;
@@ -291,11 +418,11 @@ bool Board::IsMoveLegal(const Move& move)
                 break;
         }
 
-        if (((moves & move.toPos) == 0ull) && (move.flags != MoveFlags::EnPassant))
+        if (((moves & move.ToPos()) == 0ull) && (move.flags != MoveFlags::EnPassant))
         {
             // Because of the way I generate castling moves, they will not be in 'moves'.  So this move
             // is only actually illegal if we, A: arent castling or B: are trying to do an illegal castle
-            if (((move.flags & CastleFlags)  == 0) || ((move.flags & m_boardState.legalCastles) == 0))
+            if (((move.flags & CastleFlags)  == 0) || ((move.flags & GetMasks().legalCastles) == 0))
             {
                 isLegal = false;
                 if constexpr (printReason)
@@ -320,6 +447,23 @@ template bool Board::IsMoveLegal<false, false>(const Move& move);
 // those on the first king move.  This should avoid the most expensive part of the check.
 template<bool isWhite, bool onlyCaptures>
 void Board::GenerateLegalMoves(Move** ppMoveList, uint32* pNumMoves)
+{
+    switch (ActiveSliderBackend)
+    {
+        case(SliderBackend::Pext):
+            GenerateLegalMovesWithBackend<isWhite, onlyCaptures, SliderBackend::Pext>(ppMoveList, pNumMoves);
+            break;
+        case(SliderBackend::Magic):
+            GenerateLegalMovesWithBackend<isWhite, onlyCaptures, SliderBackend::Magic>(ppMoveList, pNumMoves);
+            break;
+        default:
+            GenerateLegalMovesWithBackend<isWhite, onlyCaptures, SliderBackend::Ray>(ppMoveList, pNumMoves);
+            break;
+    }
+}
+
+template<bool isWhite, bool onlyCaptures, SliderBackend backend>
+void Board::GenerateLegalMovesWithBackend(Move** ppMoveList, uint32* pNumMoves)
 {
     GenerateCheckAndPinMask<isWhite>();
 
@@ -329,42 +473,42 @@ void Board::GenerateLegalMoves(Move** ppMoveList, uint32* pNumMoves)
 
     // Generate king moves first, becuase I assume that the king moves will generally be the best
     // moves
-    GeneratePieceMoves<wKing, isWhite, false, onlyCaptures>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+    GeneratePieceMoves<wKing, isWhite, false, onlyCaptures, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
 
     // If we're in a double check, then we can only move the king.  Don't bother generating the
     // rest of the moves
-    if (m_boardState.numPiecesChecking == 0)
+    if (GetMasks().numPiecesChecking == 0)
     {
         // need to move this further out
         if (m_boardState.enPassantSquare != 0ull)
         {
-            GeneratePieceMoves<wPawn, isWhite, true, onlyCaptures>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+            GeneratePieceMoves<wPawn, isWhite, true, onlyCaptures, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
         }
         else
         {
-            GeneratePieceMoves<wPawn,   isWhite, false, onlyCaptures>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+            GeneratePieceMoves<wPawn,   isWhite, false, onlyCaptures, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
         }
-        GeneratePieceMoves<wKnight, isWhite, false, onlyCaptures>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
-        GeneratePieceMoves<wBishop, isWhite, false, onlyCaptures>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
-        GeneratePieceMoves<wRook,   isWhite, false, onlyCaptures>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
-        GeneratePieceMoves<wQueen,  isWhite, false, onlyCaptures>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+        GeneratePieceMoves<wKnight, isWhite, false, onlyCaptures, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+        GeneratePieceMoves<wBishop, isWhite, false, onlyCaptures, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+        GeneratePieceMoves<wRook,   isWhite, false, onlyCaptures, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+        GeneratePieceMoves<wQueen,  isWhite, false, onlyCaptures, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
     }
     // If we are in check, then we generate all legal moves, not only captures
-    else if (m_boardState.numPiecesChecking == 1)
+    else if (GetMasks().numPiecesChecking == 1)
     {
         // need to move this further out
         if (m_boardState.enPassantSquare != 0ull)
         {
-            GeneratePieceMoves<wPawn, isWhite, true, false>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+            GeneratePieceMoves<wPawn, isWhite, true, false, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
         }
         else
         {
-            GeneratePieceMoves<wPawn, isWhite, false, false>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+            GeneratePieceMoves<wPawn, isWhite, false, false, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
         }
-        GeneratePieceMoves<wKnight, isWhite, false, false>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
-        GeneratePieceMoves<wBishop, isWhite, false, false>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
-        GeneratePieceMoves<wRook,   isWhite, false, false>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
-        GeneratePieceMoves<wQueen,  isWhite, false, false>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+        GeneratePieceMoves<wKnight, isWhite, false, false, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+        GeneratePieceMoves<wBishop, isWhite, false, false, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+        GeneratePieceMoves<wRook,   isWhite, false, false, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
+        GeneratePieceMoves<wQueen,  isWhite, false, false, backend>(ppMoveList, &numCaptures, &numNormal, &numProbGood);
     }
 
     ppMoveList[MoveTypes::Best][0].fromPiece                   = Piece::EndOfMoveList;
@@ -385,7 +529,146 @@ template void Board::GenerateLegalMoves<true, false>(Move** ppMoveList, uint32*
 template void Board::GenerateLegalMoves<false, false>(Move** ppMoveList, uint32* pNumMoves);
 //=================================================================================================
 
-template<Piece pieceType, bool isWhite, bool hasEnPassant, bool onlyCaptures>
+// Perft's leaf counting.  Follows GenerateLegalMoves exactly, so the counts always agree with
+// it, but only ever builds bitboards.
+template<bool isWhite>
+uint32 Board::CountLegalMoves()
+{
+    switch (ActiveSliderBackend)
+    {
+        case(SliderBackend::Pext):  return CountLegalMovesWithBackend<isWhite, SliderBackend::Pext>();
+        case(SliderBackend::Magic): return CountLegalMovesWithBackend<isWhite, SliderBackend::Magic>();
+        default:                    return CountLegalMovesWithBackend<isWhite, SliderBackend::Ray>();
+    }
+}
+
+template<bool isWhite, SliderBackend backend>
+uint32 Board::CountLegalMovesWithBackend()
+{
+    GenerateCheckAndPinMask<isWhite>();
+
+    // GetKingMoves fills in legalCastles, and every castle it allows is one move.
+    uint32 numMoves = PopCount(GetKingMoves<isWhite, false>(GetKing<isWhite>()));
+    numMoves += PopCount(GetMasks().legalCastles);
+
+    if (GetMasks().numPiecesChecking <= 1)
+    {
+        numMoves += CountPawnMoves<isWhite>();
+        numMoves += CountPieceMoves<wKnight, isWhite, backend>();
+        numMoves += CountPieceMoves<wBishop, isWhite, backend>();
+        numMoves += CountPieceMoves<wRook,   isWhite, backend>();
+        numMoves += CountPieceMoves<wQueen,  isWhite, backend>();
+    }
+
+    return numMoves;
+}
+
+template uint32 Board::CountLegalMoves<true>();
+template uint32 Board::CountLegalMoves<false>();
+
+// Knights and sliders can share target squares, so these still go one piece at a time.
+template<Piece pieceType, bool isWhite, SliderBackend backend>
+uint32 Board::CountPieceMoves()
+{
+    uint64 pieces   = GetPieces<pieceType, isWhite>();
+    uint32 numMoves = 0;
+    while (pieces != 0ull)
+    {
+        uint64 piece = GetLSB(pieces);
+        pieces ^= piece;
+
+        numMoves += PopCount(GetPieceMoves<pieceType, isWhite, false, backend>(piece));
+    }
+    return numMoves;
+}
+
+// Every pawn shifted the same way lands on a different square, so pushes and each capture
+// direction can be done for all the pawns at once and popcounted.  Pinned pawns are shifted
+// separately so they can be kept on their pin ray, the same as GetPawnMoves does one at a time.
+template<bool isWhite>
+uint32 Board::CountPawnMoves()
+{
+    constexpr uint64 promotionRow  = (isWhite) ? Top : Bottom;
+    constexpr uint64 doublePushRow = (isWhite) ? Rank3 : Rank6;   // Where a double push stops first
+
+    const uint64 pawns        = GetPawn<isWhite>();
+    const uint64 enemyPieces  = (isWhite) ? m_boardState.blackPieces : m_boardState.whitePieces;
+    const uint64 emptySquares = ~GetAllPieces();
+    const uint64 hvPinMask    = GetMasks().hvPinMask;
+    const uint64 diagPinMask  = GetMasks().diagPinMask;
+
+    // Diagonally pinned pawns can't push, pawns pinned along a rank or file can't capture.
+    const uint64 pushers   = pawns & ~diagPinMask;
+    const uint64 capturers = pawns & ~hvPinMask;
+
+    uint64 singlePushes = 0ull;
+    uint64 doublePushes = 0ull;
+    uint64 leftCaptures  = 0ull;
+    uint64 rightCaptures = 0ull;
+    if constexpr (isWhite)
+    {
+        singlePushes = (MoveUp(pushers & ~hvPinMask) | (MoveUp(pushers & hvPinMask) & hvPinMask)) &
+                       emptySquares;
+        doublePushes = MoveUp(singlePushes & doublePushRow) & emptySquares;
+
+        leftCaptures  = (MoveUpLeft(capturers & ~diagPinMask) |
+                         (MoveUpLeft(capturers & diagPinMask) & diagPinMask)) & enemyPieces;
+        rightCaptures = (MoveUpRight(capturers & ~diagPinMask) |
+                         (MoveUpRight(capturers & diagPinMask) & diagPinMask)) & enemyPieces;
+    }
+    else
+    {
+        singlePushes = (MoveDown(pushers & ~hvPinMask) | (MoveDown(pushers & hvPinMask) & hvPinMask)) &
+                       emptySquares;
+        doublePushes = MoveDown(singlePushes & doublePushRow) & emptySquares;
+
+        leftCaptures  = (MoveDownLeft(capturers & ~diagPinMask) |
+                         (MoveDownLeft(capturers & diagPinMask) & diagPinMask)) & enemyPieces;
+        rightCaptures = (MoveDownRight(capturers & ~diagPinMask) |
+                         (MoveDownRight(capturers & diagPinMask) & diagPinMask)) & enemyPieces;
+    }
+
+    const uint64 checkMask = GetMasks().checkMask;
+    singlePushes  &= checkMask;
+    doublePushes  &= checkMask;
+    leftCaptures  &= checkMask;
+    rightCaptures &= checkMask;
+
+    // Promotions are 4 moves each, one for every piece.
+    uint32 numMoves = PopCount(singlePushes)  + PopCount(doublePushes) +
+                      PopCount(leftCaptures)  + PopCount(rightCaptures);
+    numMoves += 3 * (PopCount(singlePushes & promotionRow) +
+                     PopCount(leftCaptures & promotionRow) +
+                     PopCount(rightCaptures & promotionRow));
+
+    // At most two pawns can take en passant, and the pin checks are different for each, so those
+    // go through GetPawnMoves.
+    const uint64 enPassantSquare = m_boardState.enPassantSquare;
+    if (enPassantSquare != 0ull)
+    {
+        uint64 enPassantPawns = 0ull;
+        if constexpr (isWhite)
+        {
+            enPassantPawns = (MoveDownLeft(enPassantSquare) | MoveDownRight(enPassantSquare)) & pawns;
+        }
+        else
+        {
+            enPassantPawns = (MoveUpLeft(enPassantSquare) | MoveUpRight(enPassantSquare)) & pawns;
+        }
+
+        while (enPassantPawns != 0ull)
+        {
+            uint64 pawn = GetLSB(enPassantPawns);
+            enPassantPawns ^= pawn;
+
+            numMoves += ((GetPawnMoves<isWhite, true>(pawn) & enPassantSquare) != 0ull) ? 1 : 0;
+        }
+    }
+
+    return numMoves;
+}
+
+template<Piece pieceType, bool isWhite, bool hasEnPassant, bool onlyCaptures, SliderBackend backend>
 void Board::GeneratePieceMoves(Move** ppMoveList, uint32* pNumCapture, uint32* pNumNormal, uint32* pNumProbGood)
 {
     Move* pProbGoodList = &(ppMoveList[MoveTypes::ProbablyGood][0]);
@@ -401,8 +684,9 @@ void Board::GeneratePieceMoves(Move** ppMoveList, uint32* pNumCapture, uint32* p
     {
         uint64 piece = GetLSB(pieces);
         pieces ^= piece;
+        const uint8 fromIdx = static_cast<uint8>(GetIndex(piece));
 
-        uint64 moves = GetPieceMoves<pieceType, isWhite, hasEnPassant>(piece);
+        uint64 moves = GetPieceMoves<pieceType, isWhite, hasEnPassant, backend>(piece);
 
         // Handle en passant
         if constexpr (hasEnPassant)
@@ -413,8 +697,8 @@ void Board::GeneratePieceMoves(Move** ppMoveList, uint32* pNumCapture, uint32* p
             {
                 pCaptureList[*pNumCapture].fromPiece = (isWhite) ? wPawn : bPawn;
                 pCaptureList[*pNumCapture].toPiece   = (isWhite) ? bPawn : wPawn;
-                pCaptureList[*pNumCapture].fromPos   = piece;
-                pCaptureList[*pNumCapture].toPos     = enPassantSquare;
+                pCaptureList[*pNumCapture].fromIdx   = fromIdx;
+                pCaptureList[*pNumCapture].toIdx     = static_cast<uint8>(GetIndex(enPassantSquare));
                 pCaptureList[*pNumCapture].flags     = MoveFlags::EnPassant;
                 pCaptureList[*pNumCapture].score     = ScoreMoveMVVLVA(pCaptureList[*pNumCapture]);
 
@@ -433,37 +717,38 @@ void Board::GeneratePieceMoves(Move** ppMoveList, uint32* pNumCapture, uint32* p
             {
                 uint64 promotion = GetLSB(promotions);
                 promotions ^= promotion;
+                const uint8 promotionIdx = static_cast<uint8>(GetIndex(promotion));
 
                 pProbGoodList[*pNumProbGood].fromPiece = static_cast<Piece>(pieceType + pieceTypeOffset);
-                pProbGoodList[*pNumProbGood].toPiece   = GetPieceFromPos<!isWhite>(promotion);
-                pProbGoodList[*pNumProbGood].fromPos   = piece;
-                pProbGoodList[*pNumProbGood].toPos     = promotion;
+                pProbGoodList[*pNumProbGood].toPiece   = m_mailbox[promotionIdx];
+                pProbGoodList[*pNumProbGood].fromIdx   = fromIdx;
+                pProbGoodList[*pNumProbGood].toIdx     = promotionIdx;
                 pProbGoodList[*pNumProbGood].flags     = MoveFlags::QueenPromotion;
                 pProbGoodList[*pNumProbGood].score     = ScoreMoveMVVLVA(pProbGoodList[*pNumProbGood]) + PieceScores::QueenScore;
                 *pNumProbGood += 1;
 
                 pProbGoodList[*pNumProbGood].fromPiece = static_cast<Piece>(pieceType + pieceTypeOffset);
-                pProbGoodList[*pNumProbGood].toPiece   = GetPieceFromPos<!isWhite>(promotion);
-                pProbGoodList[*pNumProbGood].fromPos   = piece;
-                pProbGoodList[*pNumProbGood].toPos     = promotion;
+                pProbGoodList[*pNumProbGood].toPiece   = m_mailbox[promotionIdx];
+                pProbGoodList[*pNumProbGood].fromIdx   = fromIdx;
+                pProbGoodList[*pNumProbGood].toIdx     = promotionIdx;
                 pProbGoodList[*pNumProbGood].flags     = MoveFlags::KnightPromotion;
                 pProbGoodList[*pNumProbGood].score     = ScoreMoveMVVLVA(pProbGoodList[*pNumProbGood]) + PieceScores::KnightScore;
 
                 *pNumProbGood += 1;
 
                 pProbGoodList[*pNumProbGood].fromPiece = static_cast<Piece>(pieceType + pieceTypeOffset);
-                pProbGoodList[*pNumProbGood].toPiece   = GetPieceFromPos<!isWhite>(promotion);
-                pProbGoodList[*pNumProbGood].fromPos   = piece;
-                pProbGoodList[*pNumProbGood].toPos     = promotion;
+                pProbGoodList[*pNumProbGood].toPiece   = m_mailbox[promotionIdx];
+                pProbGoodList[*pNumProbGood].fromIdx   = fromIdx;
+                pProbGoodList[*pNumProbGood].toIdx     = promotionIdx;
                 pProbGoodList[*pNumProbGood].flags     = MoveFlags::RookPromotion;
                 pProbGoodList[*pNumProbGood].score     = ScoreMoveMVVLVA(pProbGoodList[*pNumProbGood]) + PieceScores::RookScore;
 
                 *pNumProbGood += 1;
 
                 pProbGoodList[*pNumProbGood].fromPiece = static_cast<Piece>(pieceType + pieceTypeOffset);
-                pProbGoodList[*pNumProbGood].toPiece   = GetPieceFromPos<!isWhite>(promotion);
-                pProbGoodList[*pNumProbGood].fromPos   = piece;
-                pProbGoodList[*pNumProbGood].toPos     = promotion;
+                pProbGoodList[*pNumProbGood].toPiece   = m_mailbox[promotionIdx];
+                pProbGoodList[*pNumProbGood].fromIdx   = fromIdx;
+                pProbGoodList[*pNumProbGood].toIdx     = promotionIdx;
                 pProbGoodList[*pNumProbGood].flags     = MoveFlags::BishopPromotion;
                 pProbGoodList[*pNumProbGood].score     = ScoreMoveMVVLVA(pProbGoodList[*pNumProbGood]) + PieceScores::BishopScore;
 
@@ -477,11 +762,12 @@ void Board::GeneratePieceMoves(Move** ppMoveList, uint32* pNumCapture, uint32* p
         {
             uint64 attack = GetLSB(attacks);
             attacks ^= attack;
+            const uint8 attackIdx = static_cast<uint8>(GetIndex(attack));
 
             pCaptureList[*pNumCapture].fromPiece = static_cast<Piece>(pieceType + pieceTypeOffset);
-            pCaptureList[*pNumCapture].toPiece   = GetPieceFromPos<!isWhite>(attack);
-            pCaptureList[*pNumCapture].fromPos   = piece;
-            pCaptureList[*pNumCapture].toPos     = attack;
+            pCaptureList[*pNumCapture].toPiece   = m_mailbox[attackIdx];
+            pCaptureList[*pNumCapture].fromIdx   = fromIdx;
+            pCaptureList[*pNumCapture].toIdx     = attackIdx;
             pCaptureList[*pNumCapture].flags     = MoveFlags::NoFlag;
             pCaptureList[*pNumCapture].score     = ScoreMoveMVVLVA(pCaptureList[*pNumCapture]);
 
@@ -493,28 +779,28 @@ void Board::GeneratePieceMoves(Move** ppMoveList, uint32* pNumCapture, uint32* p
             // Handle castling
             if constexpr (pieceType == wKing)
             {
-                uint64 castleFlags = m_boardState.legalCastles;
+                uint64 castleFlags = GetMasks().legalCastles;
 
                 uint64 flag = GetLSB(castleFlags);
                 castleFlags ^= flag;
                 if (flag != 0ull)
                 {
-                    pProbGoodList[*pNumProbGood].flags     = flag;
+                    pProbGoodList[*pNumProbGood].flags     = static_cast<uint16>(flag);
                     pProbGoodList[*pNumProbGood].score     = CastleScore;
                     pProbGoodList[*pNumProbGood].fromPiece = static_cast<Piece>(pieceType + pieceTypeOffset);
                     pProbGoodList[*pNumProbGood].toPiece   = Piece::NoPiece;
-                    pProbGoodList[*pNumProbGood].toPos     = 0ull;
-                    pProbGoodList[*pNumProbGood].fromPos   = (isWhite) ? WhiteKingStart : BlackKingStart;
+                    pProbGoodList[*pNumProbGood].toIdx     = GetCastleKingLandIdx(static_cast<uint32>(flag));
+                    pProbGoodList[*pNumProbGood].fromIdx   = (isWhite) ? WhiteKingStartIdx : BlackKingStartIdx;
                     *pNumProbGood += 1;
 
                     if (castleFlags != 0ull)
                     {
-                        pProbGoodList[*pNumProbGood].flags     = castleFlags;
+                        pProbGoodList[*pNumProbGood].flags     = static_cast<uint16>(castleFlags);
                         pProbGoodList[*pNumProbGood].score     = CastleScore;
                         pProbGoodList[*pNumProbGood].fromPiece = static_cast<Piece>(pieceType + pieceTypeOffset);
                         pProbGoodList[*pNumProbGood].toPiece   = Piece::NoPiece;
-                        pProbGoodList[*pNumProbGood].toPos     = 0ull;
-                        pProbGoodList[*pNumProbGood].fromPos   = (isWhite) ? WhiteKingStart : BlackKingStart;
+                        pProbGoodList[*pNumProbGood].toIdx     = GetCastleKingLandIdx(static_cast<uint32>(castleFlags));
+                        pProbGoodList[*pNumProbGood].fromIdx   = (isWhite) ? WhiteKingStartIdx : BlackKingStartIdx;
                         *pNumProbGood += 1;
                     }
                 }
@@ -527,8 +813,8 @@ void Board::GeneratePieceMoves(Move** ppMoveList, uint32* pNumCapture, uint32* p
 
                 pNormalList[*pNumNormal].fromPiece = static_cast<Piece>(pieceType + pieceTypeOffset);
                 pNormalList[*pNumNormal].toPiece   = Piece::NoPiece;
-                pNormalList[*pNumNormal].fromPos   = piece;
-                pNormalList[*pNumNormal].toPos     = move;
+                pNormalList[*pNumNormal].fromIdx   = fromIdx;
+                pNormalList[*pNumNormal].toIdx     = static_cast<uint8>(GetIndex(move));
                 pNormalList[*pNumNormal].flags     = MoveFlags::NoFlag;
                 pNormalList[*pNumNormal].score     = 0;
                 *pNumNormal += 1;
@@ -538,20 +824,33 @@ void Board::GeneratePieceMoves(Move** ppMoveList, uint32* pNumCapture, uint32* p
 }
 
 //=================================================================================================
-template<Piece pieceType, bool isWhite, bool hasEnPassant>
+template<Piece pieceType, bool isWhite, bool hasEnPassant, SliderBackend backend>
 uint64 Board::GetPieceMoves(uint64 pos)
 {
-    CH_ASSERT(m_boardState.checkAndPinMasksValid);
+    CH_ASSERT(GetMasks().checkAndPinMasksValid);
 
     if      constexpr (pieceType == wKing)   { return GetKingMoves<isWhite, false>(pos); }
-    else if constexpr (pieceType == wQueen)  { return GetQueenMoves<isWhite, false>(pos);  }
-    else if constexpr (pieceType == wRook)   { return GetRookMoves<isWhite, false>(pos);   }
-    else if constexpr (pieceType == wBishop) { return GetBishopMoves<isWhite, false>(pos); }
+    else if constexpr (pieceType == wQueen)  { return GetQueenMoves<isWhite, false, backend>(pos);  }
+    else if constexpr (pieceType == wRook)   { return GetRookMoves<isWhite, false, backend>(pos);   }
+    else if constexpr (pieceType == wBishop) { return GetBishopMoves<isWhite, false, backend>(pos); }
     else if constexpr (pieceType == wKnight) { return GetKnightMoves<isWhite, false>(pos); }
     else if constexpr (pieceType == wPawn)   { return GetPawnMoves<isWhite, hasEnPassant>(pos);   }
     else static_assert(false);
 }
 
+// For the lookups of a single piece outside the move generation loops, which only hit the backend
+// switch once anyway.
+template<Piece pieceType, bool isWhite>
+uint64 Board::GetSliderMoves(uint64 pos)
+{
+    switch (ActiveSliderBackend)
+    {
+        case(SliderBackend::Pext):  return GetPieceMoves<pieceType, isWhite, false, SliderBackend::Pext>(pos);
+        case(SliderBackend::Magic): return GetPieceMoves<pieceType, isWhite, false, SliderBackend::Magic>(pos);
+        default:                    return GetPieceMoves<pieceType, isWhite, false, SliderBackend::Ray>(pos);
+    }
+}
+
 template<bool isWhite, bool hasEnPassant>
 uint64 Board::GetPawnMoves(uint64 pos)
 {
@@ -562,15 +861,15 @@ uint64 Board::GetPawnMoves(uint64 pos)
         bool illegalBecauseDiagPin = false;
         if constexpr (isWhite)
         {
-            illegalBecauseDiagPin = (MoveDown(m_boardState.enPassantSquare) & m_boardState.diagPinMask) != 0ull;
+            illegalBecauseDiagPin = (MoveDown(m_boardState.enPassantSquare) & GetMasks().diagPinMask) != 0ull;
         }
         else
         {
-            illegalBecauseDiagPin = (MoveUp(m_boardState.enPassantSquare) & m_boardState.diagPinMask) != 0ull;
+            illegalBecauseDiagPin = (MoveUp(m_boardState.enPassantSquare) & GetMasks().diagPinMask) != 0ull;
         }
 
         // Also illegal if we are part of the double pin to the king.
-        bool illegalBecauseDoublePin = (pos & m_boardState.doubleHorizontalPinMask) != 0ull;
+        bool illegalBecauseDoublePin = (pos & GetMasks().doubleHorizontalPinMask) != 0ull;
 
         const bool enPassantIllegal = illegalBecauseDiagPin || illegalBecauseDoublePin;
         legalEnPassantSquare = (enPassantIllegal) ? 0ull : m_boardState.enPassantSquare;
@@ -580,92 +879,73 @@ uint64 Board::GetPawnMoves(uint64 pos)
     uint64 attacks = 0ull;
 
     // If we are pinned in a direction, we can only move along the pinmask
-    const uint64 legalHvPinMoves   = ((pos & m_boardState.hvPinMask) != 0) ? m_boardState.hvPinMask : FullBoard;
-    const uint64 legalDiagPinMoves = ((pos & m_boardState.diagPinMask) != 0) ? m_boardState.diagPinMask : FullBoard;
+    const uint64 legalHvPinMoves   = ((pos & GetMasks().hvPinMask) != 0) ? GetMasks().hvPinMask : FullBoard;
+    const uint64 legalDiagPinMoves = ((pos & GetMasks().diagPinMask) != 0) ? GetMasks().diagPinMask : FullBoard;
 
     if constexpr (isWhite)
     {
         // Get the pawn pushes
-        pushes = MoveUp(pos & ~m_boardState.diagPinMask) & legalHvPinMoves & ~m_boardState.allPieces;
+        pushes = MoveUp(pos & ~GetMasks().diagPinMask) & legalHvPinMoves & ~GetAllPieces();
 
         const bool canDoublePush = pos & MoveUp(Bottom);
         pushes |= (canDoublePush) ? MoveUp(pushes) : 0ull;
-        pushes &= ~m_boardState.allPieces;
+        pushes &= ~GetAllPieces();
 
         // Get attacking moves
-        attacks = (MoveUpLeft(pos & ~m_boardState.hvPinMask) |
-                   MoveUpRight(pos & ~m_boardState.hvPinMask)) & legalDiagPinMoves
+        attacks = (MoveUpLeft(pos & ~GetMasks().hvPinMask) |
+                   MoveUpRight(pos & ~GetMasks().hvPinMask)) & legalDiagPinMoves
                                                     & (m_boardState.blackPieces | legalEnPassantSquare);
     }
     else
     {
         // Get the pawn pushes
-        pushes = MoveDown(pos & ~m_boardState.diagPinMask) & legalHvPinMoves & ~m_boardState.allPieces;
+        pushes = MoveDown(pos & ~GetMasks().diagPinMask) & legalHvPinMoves & ~GetAllPieces();
 
         const bool canDoublePush = pos & MoveDown(Top);
         pushes |= (canDoublePush) ? MoveDown(pushes) : 0ull;
-        pushes &= ~m_boardState.allPieces;
+        pushes &= ~GetAllPieces();
 
         // Get attacking moves
-        attacks = (MoveDownLeft(pos & ~m_boardState.hvPinMask) |
-                   MoveDownRight(pos & ~m_boardState.hvPinMask)) & legalDiagPinMoves
+        attacks = (MoveDownLeft(pos & ~GetMasks().hvPinMask) |
+                   MoveDownRight(pos & ~GetMasks().hvPinMask)) & legalDiagPinMoves
                                                       & (m_boardState.whitePieces | legalEnPassantSquare);
     }
-    return (pushes | attacks) & m_boardState.checkMask;
+    return (pushes | attacks) & GetMasks().checkMask;
 }
 
 template<bool isWhite, bool ignoreLegal>
 uint64 Board::GetKnightMoves(uint64 pos)
 {
-    uint64 legalKnightMoves = 0ull;
     // if the knight is in either pin mask, it can't move
     if constexpr (ignoreLegal == false)
     {
-        pos &= (~m_boardState.diagPinMask & ~m_boardState.hvPinMask);
+        pos &= (~GetMasks().diagPinMask & ~GetMasks().hvPinMask);
     }
-    const uint64 movedUp    = MoveUp(pos);
-    const uint64 movedLeft  = MoveLeft(pos);
-    const uint64 movedRight = MoveRight(pos);
-    const uint64 movedDown  = MoveDown(pos);
-
-    legalKnightMoves |= MoveUpRight(movedUp);
-    legalKnightMoves |= MoveUpLeft(movedUp);
-
-    legalKnightMoves |= MoveUpLeft(movedLeft);
-    legalKnightMoves |= MoveDownLeft(movedLeft);
-
-    legalKnightMoves |= MoveUpRight(movedRight);
-    legalKnightMoves |= MoveDownRight(movedRight);
-
-    legalKnightMoves |= MoveDownLeft(movedDown);
-    legalKnightMoves |= MoveDownRight(movedDown);
+    uint64 legalKnightMoves = GetKnightAttacks(pos);
 
     if constexpr (ignoreLegal == false)
     {
         const uint64 teamPieces = (isWhite) ? m_boardState.whitePieces : m_boardState.blackPieces;
         legalKnightMoves &= ~teamPieces;
     
-        legalKnightMoves &= m_boardState.checkMask;
+        legalKnightMoves &= GetMasks().checkMask;
     }
     return legalKnightMoves;
 }
 
-template<bool isWhite, bool ignoreLegal>
+template<bool isWhite, bool ignoreLegal, SliderBackend backend>
 uint64 Board::GetBishopMoves(uint64 pos)
 {
-    uint64 moves = CastRayToBlocker<NorthEast>(pos, m_boardState.allPieces) |
-                   CastRayToBlocker<NorthWest>(pos, m_boardState.allPieces) |
-                   CastRayToBlocker<SouthEast>(pos, m_boardState.allPieces) |
-                   CastRayToBlocker<SouthWest>(pos, m_boardState.allPieces);
+    uint64 moves = GetBishopAttacks<backend>(pos);
 
     if constexpr (ignoreLegal == false)
     {
-        const bool isPinnedDiag = (pos & m_boardState.diagPinMask) != 0ull;
-        const bool isPinnedHv   = (pos & m_boardState.hvPinMask) != 0ull;
+        const bool isPinnedDiag = (pos & GetMasks().diagPinMask) != 0ull;
+        const bool isPinnedHv   = (pos & GetMasks().hvPinMask) != 0ull;
 
-        moves = (isPinnedDiag) ? (moves & m_boardState.diagPinMask) : moves;
+        moves = (isPinnedDiag) ? (moves & GetMasks().diagPinMask) : moves;
         moves = (isPinnedHv) ? 0ull : moves;
-        moves &= m_boardState.checkMask;
+        moves &= GetMasks().checkMask;
 
         const uint64 teamPieces = (isWhite) ? m_boardState.whitePieces : m_boardState.blackPieces;
         moves &= ~teamPieces;
@@ -674,22 +954,19 @@ uint64 Board::GetBishopMoves(uint64 pos)
     return moves;
 }
 
-template<bool isWhite, bool ignoreLegal>
+template<bool isWhite, bool ignoreLegal, SliderBackend backend>
 uint64 Board::GetRookMoves(uint64 pos)
 {
-    uint64 moves = CastRayToBlocker<North>(pos, m_boardState.allPieces) |
-                   CastRayToBlocker<East>(pos, m_boardState.allPieces)  |
-                   CastRayToBlocker<South>(pos, m_boardState.allPieces) |
-                   CastRayToBlocker<West>(pos, m_boardState.allPieces);
+    uint64 moves = GetRookAttacks<backend>(pos);
 
     if constexpr (ignoreLegal == false)
     {
-        const bool isPinnedDiag = (pos & m_boardState.diagPinMask) != 0ull;
-        const bool isPinnedHv = (pos & m_boardState.hvPinMask) != 0ull;
+        const bool isPinnedDiag = (pos & GetMasks().diagPinMask) != 0ull;
+        const bool isPinnedHv = (pos & GetMasks().hvPinMask) != 0ull;
 
-        moves = (isPinnedHv) ? (moves & m_boardState.hvPinMask) : moves;
+        moves = (isPinnedHv) ? (moves & GetMasks().hvPinMask) : moves;
         moves = (isPinnedDiag) ? 0ull : moves;
-        moves &= m_boardState.checkMask;
+        moves &= GetMasks().checkMask;
 
         const uint64 teamPieces = (isWhite) ? m_boardState.whitePieces : m_boardState.blackPieces;
         moves &= ~teamPieces;
@@ -697,10 +974,10 @@ uint64 Board::GetRookMoves(uint64 pos)
     return moves;
 }
 
-template<bool isWhite, bool ignoreLegal>
+template<bool isWhite, bool ignoreLegal, SliderBackend backend>
 uint64 Board::GetQueenMoves(uint64 pos)
 {
-    return GetBishopMoves<isWhite, ignoreLegal>(pos) | GetRookMoves<isWhite, ignoreLegal>(pos);
+    return GetBishopMoves<isWhite, ignoreLegal, backend>(pos) | GetRookMoves<isWhite, ignoreLegal, backend>(pos);
 }
 
 // I should move the checking seen squares out of here and check them on the first attempted move
@@ -708,53 +985,45 @@ uint64 Board::GetQueenMoves(uint64 pos)
 template<bool isWhite, bool ignoreLegal>
 uint64 Board::GetKingMoves(uint64 pos)
 {
-    uint64 kingMoves = 0ull;
-    kingMoves |= MoveUp(pos);
-    kingMoves |= MoveLeft(pos);
-    kingMoves |= MoveRight(pos);
-    kingMoves |= MoveDown(pos);
-    kingMoves |= MoveUpLeft(pos);
-    kingMoves |= MoveUpRight(pos);
-    kingMoves |= MoveDownLeft(pos);
-    kingMoves |= MoveDownRight(pos);
+    uint64 kingMoves = GetKingAttacks(pos);
 
     if constexpr (ignoreLegal == false)
     {
         GenerateIllegalKingMoveMask<isWhite>();
-        kingMoves &= ~m_boardState.illegalKingMoveMask;
+        kingMoves &= ~GetMasks().illegalKingMoveMask;
 
-        const uint64 seenAndOccupiedSquares = m_boardState.illegalKingMoveMask | m_boardState.allPieces;
+        const uint64 seenAndOccupiedSquares = GetMasks().illegalKingMoveMask | GetAllPieces();
         if constexpr (isWhite)
         {
             const uint64 kingSideSafeSquares = MoveRight(pos) | WhiteKingSideCastleLand;
-            const bool kingSideCastle = (m_boardState.checkMask == FullBoard) &&
+            const bool kingSideCastle = (GetMasks().checkMask == FullBoard) &&
                                         ((kingSideSafeSquares & seenAndOccupiedSquares) == 0ull) &&
                                         ((m_boardState.castleMask & WhiteKingCastle) != 0);
 
             const uint64 queenSideSafeSquares = MoveLeft(pos) | WhiteQueenSideCastleLand;
-            const bool queenSideCastle = (m_boardState.checkMask == FullBoard) &&
+            const bool queenSideCastle = (GetMasks().checkMask == FullBoard) &&
                                         ((queenSideSafeSquares & seenAndOccupiedSquares) == 0ull) &&
                                         ((m_boardState.castleMask & WhiteQueenCastle) != 0) &&
-                                        ((m_boardState.allPieces & MoveRight(WhiteQueenSideRookStart)) == 0);
+                                        ((GetAllPieces() & MoveRight(WhiteQueenSideRookStart)) == 0);
 
-            m_boardState.legalCastles |= (kingSideCastle)  ? WhiteKingCastle  : 0;
-            m_boardState.legalCastles |= (queenSideCastle) ? WhiteQueenCastle : 0;
+            GetMasks().legalCastles |= (kingSideCastle)  ? WhiteKingCastle  : 0;
+            GetMasks().legalCastles |= (queenSideCastle) ? WhiteQueenCastle : 0;
         }
         else
         {
             const uint64 kingSideSafeSquares = MoveRight(pos) | BlackKingSideCastleLand;
-            const bool kingSideCastle = (m_boardState.checkMask == FullBoard) &&
+            const bool kingSideCastle = (GetMasks().checkMask == FullBoard) &&
                                         ((kingSideSafeSquares & seenAndOccupiedSquares) == 0ull) &&
                                         ((m_boardState.castleMask & BlackKingCastle) != 0);
 
             const uint64 queenSideSafeSquares = MoveLeft(pos) | BlackQueenSideCastleLand;
-            const bool queenSideCastle = (m_boardState.checkMask == FullBoard) &&
+            const bool queenSideCastle = (GetMasks().checkMask == FullBoard) &&
                                          ((queenSideSafeSquares & seenAndOccupiedSquares) == 0ull) &&
                                          ((m_boardState.castleMask & BlackQueenCastle) != 0) &&
-                                         ((m_boardState.allPieces & MoveRight(BlackQueenSideRookStart)) == 0);
+                                         ((GetAllPieces() & MoveRight(BlackQueenSideRookStart)) == 0);
 
-            m_boardState.legalCastles |= (kingSideCastle)  ? BlackKingCastle  : 0;
-            m_boardState.legalCastles |= (queenSideCastle) ? BlackQueenCastle : 0;
+            GetMasks().legalCastles |= (kingSideCastle)  ? BlackKingCastle  : 0;
+            GetMasks().legalCastles |= (queenSideCastle) ? BlackQueenCastle : 0;
         }
         
     }
@@ -762,135 +1031,153 @@ uint64 Board::GetKingMoves(uint64 pos)
     return kingMoves;
 }
 
-// To be used for pruning king moves.  Returns all the squares that could be attacked by pawns,
-// knights, and the enemy king.
 template<bool isWhite>
-uint64 Board::GetPawnKnightKingSeenSquares()
+const AttackInfo& Board::GetAttackInfo()
 {
-    uint64 seenSquares = 0ull;
-    uint64 knights = GetKnight<isWhite>();
-    uint64 pawns   = GetPawn<isWhite>();
-    uint64 kingPos = GetKing<isWhite>();
+    AttackInfo& attackInfo = m_attackInfo[m_undoStackSize];
+    FillAttackInfo<isWhite>(&attackInfo);
+    return attackInfo;
+}
 
-    seenSquares |= GetKnightMoves<isWhite, true>(knights);
-    if constexpr (isWhite)
+template const AttackInfo& Board::GetAttackInfo<true>();
+template const AttackInfo& Board::GetAttackInfo<false>();
+
+template<bool isWhite>
+void Board::FillAttackInfo(AttackInfo* pAttackInfo) const
+{
+    if (pAttackInfo->valid[GetAttackSide(isWhite)])
     {
-        seenSquares |= MoveUpLeft(pawns) | MoveUpRight(pawns);
+        return;
     }
-    else
+
+    switch (ActiveSliderBackend)
     {
-        seenSquares |= MoveDownLeft(pawns) | MoveDownRight(pawns);
+        case(SliderBackend::Pext):
+            GenerateAttackInfo<isWhite, SliderBackend::Pext>(pAttackInfo);
+            break;
+        case(SliderBackend::Magic):
+            GenerateAttackInfo<isWhite, SliderBackend::Magic>(pAttackInfo);
+            break;
+        default:
+            GenerateAttackInfo<isWhite, SliderBackend::Ray>(pAttackInfo);
+            break;
     }
-
-    seenSquares |= GetKingMoves<isWhite, true>(kingPos);
-
-    return seenSquares;
 }
 
-template uint64 Board::GetPawnKnightKingSeenSquares<true>();
-template uint64 Board::GetPawnKnightKingSeenSquares<false>();
+template void Board::FillAttackInfo<true>(AttackInfo* pAttackInfo) const;
+template void Board::FillAttackInfo<false>(AttackInfo* pAttackInfo) const;
 
-// Gets all the squares seen by enemy sliders.  Assumes checkmask is filled out.
-// Almost 1/4 of total perft time is spent in this function.
-template<bool isWhite>
-uint64 Board::GetSliderSeenSquares(uint64 curKingMoves)
+// Sliders are looked up one at a time so a square two of them attack goes in attackedTwice.
+template<bool isWhite, SliderBackend backend>
+void Board::GenerateAttackInfo(AttackInfo* pAttackInfo) const
 {
-    // If we already found a rook or bishop checking us, then there is no need to check it's moves
-    // again.  This doesn't work for the queen though, since it can check us, and cut us off on a
-    // differnt line.
-    uint64 alreadyInMask = (m_boardState.checkMask == FullBoard) ? 0ull : m_boardState.checkMask;
+    constexpr uint32 side      = GetAttackSide(isWhite);
+    constexpr uint32 pieceBase = (isWhite) ? Piece::wKing : Piece::bKing;
+
+    const uint64 pawns = GetPawn<isWhite>();
+    const uint64 pawnLeftAttacks  = (isWhite) ? MoveUpLeft(pawns)  : MoveDownLeft(pawns);
+    const uint64 pawnRightAttacks = (isWhite) ? MoveUpRight(pawns) : MoveDownRight(pawns);
 
-    uint64 seenSquares = 0ull;
+    uint64 attacks       = pawnLeftAttacks | pawnRightAttacks;
+    uint64 attackedTwice = pawnLeftAttacks & pawnRightAttacks;
+
+    pAttackInfo->pieceAttacks[pieceBase + Piece::wPawn] = attacks;
+
+    const uint64 kingAttacks = GetKingAttacks(GetKing<isWhite>());
+    attackedTwice |= attacks & kingAttacks;
+    attacks       |= kingAttacks;
+    pAttackInfo->pieceAttacks[pieceBase + Piece::wKing] = kingAttacks;
+
+    uint64 knightAttacks = 0ull;
+    uint64 knights       = GetKnight<isWhite>();
+    while (knights != 0ull)
+    {
+        const uint64 knight = GetLSB(knights);
+        knights ^= knight;
+
+        const uint64 pieceAttacks = GetKnightAttacks(knight);
+        attackedTwice |= attacks & pieceAttacks;
+        attacks       |= pieceAttacks;
+        knightAttacks |= pieceAttacks;
+    }
+    pAttackInfo->pieceAttacks[pieceBase + Piece::wKnight] = knightAttacks;
+
+    uint64 bishopAttacks = 0ull;
+    uint64 bishops       = GetBishop<isWhite>();
+    while (bishops != 0ull)
+    {
+        const uint64 bishop = GetLSB(bishops);
+        bishops ^= bishop;
 
-    // If a rook right next to our king, it might be cutting the king off.
-    uint64 rooks   = GetRook<isWhite>()   & ~(alreadyInMask & ~curKingMoves);
-    uint64 bishops = GetBishop<isWhite>() & ~alreadyInMask;
-    uint64 queens  = GetQueen<isWhite>();
+        const uint64 pieceAttacks = GetBishopAttacks<backend>(bishop);
+        attackedTwice |= attacks & pieceAttacks;
+        attacks       |= pieceAttacks;
+        bishopAttacks |= pieceAttacks;
+    }
+    pAttackInfo->pieceAttacks[pieceBase + Piece::wBishop] = bishopAttacks;
 
+    uint64 rookAttacks = 0ull;
+    uint64 rooks       = GetRook<isWhite>();
     while (rooks != 0ull)
     {
-        uint64 rook = GetLSB(rooks);
+        const uint64 rook = GetLSB(rooks);
         rooks ^= rook;
-        seenSquares |= GetRookMoves<isWhite, true>(rook);
+
+        const uint64 pieceAttacks = GetRookAttacks<backend>(rook);
+        attackedTwice |= attacks & pieceAttacks;
+        attacks       |= pieceAttacks;
+        rookAttacks   |= pieceAttacks;
     }
+    pAttackInfo->pieceAttacks[pieceBase + Piece::wRook] = rookAttacks;
+
+    uint64 queenAttacks = 0ull;
+    uint64 queens       = GetQueen<isWhite>();
     while (queens != 0ull)
     {
-        uint64 queen = GetLSB(queens);
+        const uint64 queen = GetLSB(queens);
         queens ^= queen;
-        seenSquares |= GetQueenMoves<isWhite, true>(queen);
-    }
-    while (bishops != 0ull)
-    {
-        uint64 bishop = GetLSB(bishops);
-        bishops ^= bishop;
-        seenSquares |= GetBishopMoves<isWhite, true>(bishop);
+
+        const uint64 pieceAttacks = GetRookAttacks<backend>(queen) | GetBishopAttacks<backend>(queen);
+        attackedTwice |= attacks & pieceAttacks;
+        attacks       |= pieceAttacks;
+        queenAttacks  |= pieceAttacks;
     }
+    pAttackInfo->pieceAttacks[pieceBase + Piece::wQueen] = queenAttacks;
 
-    return seenSquares;
+    pAttackInfo->attacks[side]         = attacks;
+    pAttackInfo->attackedTwice[side]   = attackedTwice;
+    pAttackInfo->kingZoneAttacks[side] = attacks & GetKingAttacks(GetKing<!isWhite>());
+    pAttackInfo->valid[side]           = true;
 }
 
-template uint64 Board::GetSliderSeenSquares<true>(uint64 curKingMoves);
-template uint64 Board::GetSliderSeenSquares<false>(uint64 curKingMoves);
-
 template<bool isWhite>
 void Board::GenerateIllegalKingMoveMask()
 {
-    if (m_boardState.illegalKingMovesValid == false)
+    if (GetMasks().illegalKingMovesValid == false)
     {
         // we need the check mask here.
         GenerateCheckAndPinMask<isWhite>();
 
         // This doesn't fully prune all king moves, but should get rid of some clearly illegal moves.
         // Can't move into check
-        uint64 illegalMoves = (m_boardState.checkMask == FullBoard) ? 0ull : m_boardState.checkMask;
+        uint64 illegalMoves = (GetMasks().checkMask == FullBoard) ? 0ull : GetMasks().checkMask;
         // We can move onto the checkmask only if we are capturing the checking piece
         illegalMoves &= ~((isWhite) ? m_boardState.blackPieces : m_boardState.whitePieces);
         // Can't move onto our own team
         illegalMoves |= ((isWhite) ? m_boardState.whitePieces : m_boardState.blackPieces);
         // Can't move onto a square behing a sliding piece giving check
-        illegalMoves |= m_boardState.kingXRayMoveMask;
+        illegalMoves |= GetMasks().kingXRayMoveMask;
 
-        uint64 enemySeenSquares = GetPawnKnightKingSeenSquares<!isWhite>();
-        enemySeenSquares |= GetSliderSeenSquares<!isWhite>(FullBoard);
+        const uint64 enemySeenSquares = GetAttackInfo<!isWhite>().attacks[GetAttackSide(!isWhite)];
 
-        m_boardState.illegalKingMoveMask = illegalMoves | enemySeenSquares;
-        m_boardState.illegalKingMovesValid = true;
+        GetMasks().illegalKingMoveMask = illegalMoves | enemySeenSquares;
+        GetMasks().illegalKingMovesValid = true;
     }
 }
 
 template void Board::GenerateIllegalKingMoveMask<true>();
 template void Board::GenerateIllegalKingMoveMask<false>();
 
-template<bool isWhite>
-Piece Board::GetPieceFromPos(uint64 pos)
-{
-    Piece piece = NoPiece;
-    if constexpr (isWhite)
-    {
-        piece = (IsWhiteKing(pos))   ? wKing   :
-                (IsWhiteQueen(pos))  ? wQueen  :
-                (IsWhiteRook(pos))   ? wRook   :
-                (IsWhiteBishop(pos)) ? wBishop :
-                (IsWhiteKnight(pos)) ? wKnight :
-                (IsWhitePawn(pos))   ? wPawn   :
-                NoPiece;
-    }
-    else
-    {
-        piece = (IsBlackKing(pos))   ? bKing   :
-                (IsBlackQueen(pos))  ? bQueen  :
-                (IsBlackRook(pos))   ? bRook   :
-                (IsBlackBishop(pos)) ? bBishop :
-                (IsBlackKnight(pos)) ? bKnight :
-                (IsBlackPawn(pos))   ? bPawn   :
-                NoPiece;
-    }
-    return piece;
-}
-
-template Piece Board::GetPieceFromPos<true>(uint64 pos);
-template Piece Board::GetPieceFromPos<false>(uint64 pos);
-
 uint64 Board::GetLegalMoves(uint64 pos)
 {
     bool isWhite = IsWhite(pos);
@@ -905,20 +1192,20 @@ uint64 Board::GetLegalMoves(uint64 pos)
 
     uint64 legalMoves = 0ull;
     if      (IsWhiteKing(pos))   legalMoves = GetKingMoves<true, false>(pos);
-    else if (IsWhiteQueen(pos))  legalMoves = GetQueenMoves<true, false>(pos);
-    else if (IsWhiteRook(pos))   legalMoves = GetRookMoves<true, false>(pos);
-    else if (IsWhiteBishop(pos)) legalMoves = GetBishopMoves<true, false>(pos);
+    else if (IsWhiteQueen(pos))  legalMoves = GetSliderMoves<wQueen, true>(pos);
+    else if (IsWhiteRook(pos))   legalMoves = GetSliderMoves<wRook, true>(pos);
+    else if (IsWhiteBishop(pos)) legalMoves = GetSliderMoves<wBishop, true>(pos);
     else if (IsWhiteKnight(pos)) legalMoves = GetKnightMoves<true, false>(pos);
     else if (IsWhitePawn(pos))   legalMoves = GetPawnMoves<true, false>(pos);
 
     else if (IsBlackKing(pos))   legalMoves = GetKingMoves<false, false>(pos);
-    else if (IsBlackQueen(pos))  legalMoves = GetQueenMoves<false, false>(pos);
-    else if (IsBlackRook(pos))   legalMoves = GetRookMoves<false, false>(pos);
-    else if (IsBlackBishop(pos)) legalMoves = GetBishopMoves<false, false>(pos);
+    else if (IsBlackQueen(pos))  legalMoves = GetSliderMoves<wQueen, false>(pos);
+    else if (IsBlackRook(pos))   legalMoves = GetSliderMoves<wRook, false>(pos);
+    else if (IsBlackBishop(pos)) legalMoves = GetSliderMoves<wBishop, false>(pos);
     else if (IsBlackKnight(pos)) legalMoves = GetKnightMoves<false, false>(pos);
     else if (IsBlackPawn(pos))   legalMoves = GetPawnMoves<false, false>(pos);
 
-    if ((m_boardState.numPiecesChecking > 1) && (IsWhiteKing(pos) == false) && (IsBlackKing(pos) == false))
+    if ((GetMasks().numPiecesChecking > 1) && (IsWhiteKing(pos) == false) && (IsBlackKing(pos) == false))
     {
         legalMoves = 0ull;
     }
@@ -7,8 +7,20 @@
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <algorithm>
 
 ChessGame::ChessGame()
+:
+m_compareEngineInit(false),
+m_transTableSizeMB(DefaultTransTableSizeMB),
+m_evalCacheSizeKB(DefaultEvalCacheSizeKB),
+m_interleaveNuma(DefaultInterleaveTransTables),
+m_pNnueNetwork(nullptr),
+m_useNnue(true),
+m_uciSearchThread(),
+m_uciStop(false),
+m_uciSearchDone(true),
+m_uciNumThreads(1)
 {
 
 }
@@ -20,9 +32,25 @@ ChessGame::~ChessGame()
 
 Result ChessGame::Init()
 {
-    m_board.Init();
+    if (m_board.Init() == Result::Error)
+    {
+        return Result::Error;
+    }
+
+    SelectNnueBackend();
+    m_pNnueNetwork = new NnueNetwork();
+    if (LoadNnueFile(DefaultNnueFileName))
+    {
+        std::cout << "Eval: nnue, " << DefaultNnueFileName << " ("
+                  << GetNnueBackendName(ActiveNnueBackend) << ")" << std::endl;
+    }
+    else
+    {
+        std::cout << "Eval: hce, no " << DefaultNnueFileName << " loaded" << std::endl;
+    }
 
-    m_historyVec.push_back(m_board);
+    m_historyVec.emplace_back();
+    m_board.SaveSnapshot(&m_historyVec.back());
     GenerateCommandMap();
 
     m_engine.Init(&m_board);
@@ -34,9 +62,50 @@ Result ChessGame::Destroy()
 {
     m_board.Destroy();
     m_engine.Destroy();
+    if (m_compareEngineInit)
+    {
+        m_compareEngine.Destroy();
+    }
+
+    m_board.SetNnueNetwork(nullptr);
+    delete m_pNnueNetwork;
+    m_pNnueNetwork = nullptr;
     return Result::ErrorNotImplemented;
 }
 
+bool ChessGame::LoadNnueFile(const char* pFileName)
+{
+    const bool loaded = m_pNnueNetwork->LoadFromFile(pFileName);
+    SelectEvaluator();
+    return loaded;
+}
+
+void ChessGame::SelectEvaluator()
+{
+    const bool useNnue = m_useNnue && m_pNnueNetwork->IsLoaded();
+    m_board.SetNnueNetwork((useNnue) ? m_pNnueNetwork : nullptr);
+
+    m_engine.ResetEvalCache();
+    if (m_compareEngineInit)
+    {
+        m_compareEngine.ResetEvalCache();
+    }
+}
+
+bool ChessGame::ReallocTransTables()
+{
+    const uint32 sizeMB = m_transTableSizeMB;
+
+    bool allocated = m_engine.InitTransTable(sizeMB, m_interleaveNuma);
+    if (m_compareEngineInit)
+    {
+        allocated = m_compareEngine.InitTransTable(sizeMB, m_interleaveNuma) && allocated;
+    }
+
+    m_transTableSizeMB = m_engine.GetTransTableSizeMB();
+    return allocated;
+}
+
 void ChessGame::Run()
 {
     bool running = true;
@@ -84,7 +153,7 @@ void ChessGame::Run()
                 if (m_historyVec.size() > 1)
                 {
                     m_historyVec.pop_back();
-                    m_board = m_historyVec.back();
+                    m_board.RestoreSnapshot(m_historyVec.back());
                 }
                 else
                 {
@@ -92,38 +161,132 @@ void ChessGame::Run()
                 }
                 break;
             case (Commands::Perft):
-                m_engine.DoPerft(command.perft.depth, command.perft.isWhite, command.perft.expanded);
+                m_engine.DoPerft(command.perft.depth,
+                                 command.perft.isWhite,
+                                 command.perft.expanded,
+                                 command.perft.numThreads,
+                                 command.perft.reportSpeedup,
+                                 command.perft.useHash);
                 break;
             case (Commands::Engine):
+                if (command.engine.reportSpeedup)
+                {
+                    DoSmpSpeedup(command.engine.settings);
+                    break;
+                }
                 std::atomic<bool> isTimedOut = false;
                 m_engine.DoEngine(command.engine.settings, isTimedOut);
                 break;
             case (Commands::Compare):
-                DoCompareEngines(command.compare.whiteEngine, command.compare.blackEngine);
+                DoCompareEngines(command.compare.whiteEngine,
+                                 command.compare.blackEngine,
+                                 command.compare.sharedTT);
                 break;
             case (Commands::Error):
                 std::cout << "Invlaid Input" << std::endl;
                 break;
             case(Commands::Score):
                 std::cout << "Score: " << ((float)m_board.ScoreBoard<true>())/PawnScore << std::endl;
+                if (m_board.UsesNnue())
+                {
+                    // The network scores for the side to move, this is for white like the above.
+                    const int32 nnueScore = m_board.GetBoardStateIsWhiteTurn() ?
+                                            m_board.EvaluateNnue<true>() :
+                                            -m_board.EvaluateNnue<false>();
+                    std::cout << "NNUE:  " << ((float)nnueScore)/PawnScore << std::endl;
+                }
+                break;
+            case(Commands::TTStress):
+                m_engine.DoTTStressTest(command.ttStress.numThreads, command.ttStress.numWalks);
+                break;
+            case(Commands::TTBench):
+                m_engine.DoTTBenchmark();
+                break;
+            case(Commands::MakeBench):
+                m_engine.DoMakeMoveBenchmark();
+                break;
+            case(Commands::Uci):
+                RunUci();
+                running = false;
+                break;
+            case(Commands::PerftSuite):
+                DoPerftSuite(command.perftSuite.fileName,
+                             command.perftSuite.maxDepth,
+                             command.perftSuite.numThreads,
+                             command.perftSuite.useHash);
+                break;
+            case(Commands::Hash):
+            case(Commands::Numa):
+                if (command.command == Commands::Hash)
+                {
+                    m_transTableSizeMB = command.hash.size;
+                }
+                else
+                {
+                    m_interleaveNuma = command.numa.interleave;
+                }
+
+                if (ReallocTransTables() == false)
+                {
+                    std::cout << "Couldn't allocate that much, the table is "
+                              << m_transTableSizeMB << " MB" << std::endl;
+                }
+                m_engine.PrintTransTableMemory();
+                break;
+            case(Commands::EvalHash):
+                m_evalCacheSizeKB = command.hash.size;
+                m_engine.SetEvalCacheSizeKB(m_evalCacheSizeKB);
+                if (m_compareEngineInit)
+                {
+                    m_compareEngine.SetEvalCacheSizeKB(m_evalCacheSizeKB);
+                }
+                break;
+            case(Commands::Evaluator):
+                m_useNnue = command.evaluator.useNnue;
+                if (m_useNnue && (m_pNnueNetwork->IsLoaded() == false))
+                {
+                    std::cout << "No network loaded, use evalfile first" << std::endl;
+                }
+                SelectEvaluator();
+                break;
+            case(Commands::EvalFile):
+                if (LoadNnueFile(command.evalFile.fileName) == false)
+                {
+                    std::cout << "Couldn't load " << command.evalFile.fileName << std::endl;
+                }
                 break;
             default:
                 CH_ASSERT(false);
         }
-        if (memcmp(&m_board, &m_historyVec.back(), sizeof(Board)) != 0)
+        if (m_board.IsSamePosition(m_historyVec.back()) == false)
         {
-            m_historyVec.push_back(m_board);
+            m_historyVec.emplace_back();
+            m_board.SaveSnapshot(&m_historyVec.back());
         }
         std::cout << std::flush;
     }
 }
 
-void ChessGame::DoCompareEngines(EngineSettings whiteEngine, EngineSettings blackEngine)
+void ChessGame::DoCompareEngines(
+    EngineSettings whiteEngine,
+    EngineSettings blackEngine,
+    bool           sharedTT)
 {
     int32 checkMateDepth = NotCheckMate;
 
+    if ((sharedTT == false) && (m_compareEngineInit == false))
+    {
+        m_compareEngine.Init(&m_board);
+        m_compareEngine.InitTransTable(m_transTableSizeMB, m_interleaveNuma);
+        m_compareEngine.SetEvalCacheSizeKB(m_evalCacheSizeKB);
+        m_compareEngineInit = true;
+    }
+    ChessEngine* pBlackEngine = sharedTT ? &m_engine : &m_compareEngine;
+
     m_engine.ResetTransTable();
     m_engine.ResetKillers();
+    pBlackEngine->ResetTransTable();
+    pBlackEngine->ResetKillers();
 
     auto startTime = std::chrono::steady_clock::now();
 
@@ -174,6 +337,7 @@ void ChessGame::DoCompareEngines(EngineSettings whiteEngine, EngineSettings blac
         moveIsDone.store(false);
 
         std::thread doEngineThread([this,
+                                    pBlackEngine,
                                     whiteEngine, 
                                     blackEngine,
                                     &whitesTurn,
@@ -191,7 +355,7 @@ void ChessGame::DoCompareEngines(EngineSettings whiteEngine, EngineSettings blac
                 }
                 else
                 {
-                    curMove = m_engine.DoEngine(blackEngine, isTimedOut, &maxDepth, &isMoveLegal);
+                    curMove = pBlackEngine->DoEngine(blackEngine, isTimedOut, &maxDepth, &isMoveLegal);
                     isDrawByRepetition = m_board.IsDrawByRepetition<false>();
                 }
                 moveIsDone.store(true);
@@ -231,6 +395,7 @@ void ChessGame::DoCompareEngines(EngineSettings whiteEngine, EngineSettings blac
         }
 
         m_engine.ResetKillers();
+        pBlackEngine->ResetKillers();
 
         std::string moveStr   = m_board.GetStringFromMove(curMove);
         std::string moveScore = m_engine.ConvertScoreToStr(curMove.score, &checkMateDepth);
@@ -277,9 +442,103 @@ void ChessGame::DoCompareEngines(EngineSettings whiteEngine, EngineSettings blac
     }
 }
 
+// Only the perft suite makes sense without a board to look at.  Exits 0 if every count matched, 1
+// if any didn't or a line of the file was malformed, and 2 if the command or the file couldn't be
+// used, including a file with nothing to check at the depth asked for.
+int32 ChessGame::RunCommandLine(int32 argc, char** argv)
+{
+    std::string inputLine;
+    for (int32 arg = 1; arg < argc; arg++)
+    {
+        inputLine += std::string(argv[arg]) + " ";
+    }
+
+    int32 exitCode = 2;
+    if (inputLine.length() < MaxCommandLength)
+    {
+        InputCommand command = ParseInput(inputLine);
+        if (command.command == Commands::PerftSuite)
+        {
+            const Result result = DoPerftSuite(command.perftSuite.fileName,
+                                               command.perftSuite.maxDepth,
+                                               command.perftSuite.numThreads,
+                                               command.perftSuite.useHash);
+            exitCode = (result == Result::Success)           ? 0 :
+                       (result == Result::ErrorInvalidInput) ? 2 : 1;
+            if (result == Result::ErrorInvalidInput)
+            {
+                return exitCode;
+            }
+        }
+    }
+
+    if (exitCode == 2)
+    {
+        std::cout << "Usage: Chess_cpp perftsuite <file.epd> [depth N] [threads N] [hash]"
+                  << std::endl;
+    }
+    return exitCode;
+}
+
+// Runs the same search single threaded and then with all the threads, starting each one from an
+// empty transposition table.  Fixed depth searches compare time to depth, timed searches compare
+// the depth reached.
+void ChessGame::DoSmpSpeedup(EngineSettings settings)
+{
+    const uint32 threadCounts[2] = { 1, std::max<uint32>(settings.numThreads, 1) };
+
+    TimeType runTimes[2]     = {};
+    uint64   runPositions[2] = {};
+    uint32   runDepths[2]    = {};
+
+    settings.printStats = false;
+    settings.doMove     = false;
+
+    for (uint32 run = 0; run < 2; run++)
+    {
+        m_engine.ResetTransTable();
+        m_engine.ResetKillers();
+
+        std::atomic<bool> isTimedOut;
+        isTimedOut.store(false);
+
+        settings.numThreads = threadCounts[run];
+
+        auto startTime = std::chrono::steady_clock::now();
+        Move bestMove  = m_engine.DoEngine(settings, isTimedOut, &(runDepths[run]));
+        auto endTime   = std::chrono::steady_clock::now();
+
+        runTimes[run]     = std::max(std::chrono::duration_cast<TimeType>(endTime - startTime),
+                                     TimeType(1));
+        runPositions[run] = m_engine.GetPositionsSearched();
+
+        uint64 knps = runPositions[run] / runTimes[run].count();
+
+        std::cout << "Threads: " << threadCounts[run]
+                  << " -- move: "  << m_board.GetStringFromMove(bestMove)
+                  << " -- depth: " << runDepths[run]
+                  << " -- time: "  << runTimes[run].count() << " ms"
+                  << " -- Knps: "  << knps << std::endl;
+    }
+
+    const float singleKnps = static_cast<float>(runPositions[0]) / runTimes[0].count();
+    const float multiKnps  = static_cast<float>(runPositions[1]) / runTimes[1].count();
+
+    std::cout << "Nps scaling      : " << multiKnps / singleKnps << "x" << std::endl;
+    if (settings.useTime == false)
+    {
+        const float timeToDepthSpeedup = static_cast<float>(runTimes[0].count()) /
+                                         runTimes[1].count();
+        std::cout << "Time to depth    : " << timeToDepthSpeedup << "x" << std::endl;
+    }
+}
+
 InputCommand ChessGame::ParseInput(std::string inputStr)
 {
     CH_ASSERT(inputStr.length() < MaxCommandLength);
+    // File names have to keep their case
+    const std::string caseStr = inputStr;
+
     // First, make the string lowercase
     for (uint32 idx = 0; idx < inputStr.length(); idx++)
     {
@@ -346,6 +605,31 @@ InputCommand ChessGame::ParseInput(std::string inputStr)
                 break;
             case(Commands::Score):
                 break;
+            case(Commands::TTStress):
+                result = ParseTTStressCommand(inputWords, &inputCommand);
+                break;
+            case(Commands::TTBench):
+                break;
+            case(Commands::MakeBench):
+                break;
+            case(Commands::Hash):
+            case(Commands::EvalHash):
+                result = ParseHashCommand(inputWords, &inputCommand);
+                break;
+            case(Commands::Uci):
+                break;
+            case(Commands::PerftSuite):
+                result = ParsePerftSuiteCommand(inputWords, caseStr, &inputCommand);
+                break;
+            case(Commands::Evaluator):
+                result = ParseEvaluatorCommand(inputWords, &inputCommand);
+                break;
+            case(Commands::EvalFile):
+                result = ParseEvalFileCommand(inputWords, caseStr, &inputCommand);
+                break;
+            case(Commands::Numa):
+                result = ParseNumaCommand(inputWords, &inputCommand);
+                break;
             default:
                 CH_ASSERT(false);
                 std::cout << "Invalid Command" << std::endl;
@@ -362,18 +646,28 @@ InputCommand ChessGame::ParseInput(std::string inputStr)
 
 void ChessGame::GenerateCommandMap()
 {
-    m_commandMap["move"]    = Commands::Move;
-    m_commandMap["reset"]   = Commands::Reset;
-    m_commandMap["quit"]    = Commands::Quit;
-    m_commandMap["exit"]    = Commands::Quit;
-    m_commandMap["print"]   = Commands::Print;
-    m_commandMap["none"]    = Commands::None;
-    m_commandMap["undo"]    = Commands::Undo;
-    m_commandMap["perft"]   = Commands::Perft;
-    m_commandMap["engine"]  = Commands::Engine;
-    m_commandMap["search"]  = Commands::Engine;
-    m_commandMap["compare"] = Commands::Compare;
-    m_commandMap["score"]   = Commands::Score;
+    m_commandMap["move"]      = Commands::Move;
+    m_commandMap["reset"]     = Commands::Reset;
+    m_commandMap["quit"]      = Commands::Quit;
+    m_commandMap["exit"]      = Commands::Quit;
+    m_commandMap["print"]     = Commands::Print;
+    m_commandMap["none"]      = Commands::None;
+    m_commandMap["undo"]      = Commands::Undo;
+    m_commandMap["perft"]     = Commands::Perft;
+    m_commandMap["engine"]    = Commands::Engine;
+    m_commandMap["search"]    = Commands::Engine;
+    m_commandMap["compare"]   = Commands::Compare;
+    m_commandMap["score"]     = Commands::Score;
+    m_commandMap["ttstress"]  = Commands::TTStress;
+    m_commandMap["ttbench"]   = Commands::TTBench;
+    m_commandMap["makebench"] = Commands::MakeBench;
+    m_commandMap["hash"]      = Commands::Hash;
+    m_commandMap["evalhash"]  = Commands::EvalHash;
+    m_commandMap["uci"]       = Commands::Uci;
+    m_commandMap["perftsuite"] = Commands::PerftSuite;
+    m_commandMap["evaluator"] = Commands::Evaluator;
+    m_commandMap["evalfile"]  = Commands::EvalFile;
+    m_commandMap["numa"]      = Commands::Numa;
 }
 
 Result ChessGame::ParseMoveCommand(
@@ -393,12 +687,10 @@ Result ChessGame::ParseMoveCommand(
         uint32 fromFile = fromStr[0] - 'a';
         uint32 fromRank = fromStr[1] - '1';
         uint32 fromIdx  = fromFile + fromRank * 8;
-        uint64 fromPos = 1ull << fromIdx;
 
         uint32 toFile   = toStr[0] - 'a';
         uint32 toRank   = toStr[1] - '1';
         uint32 toIdx    = toFile + toRank * 8;
-        uint64 toPos    = 1ull << toIdx;
 
         if ((fromIdx < 0) || (fromIdx > 63) ||
             (toIdx < 0) || (toIdx > 63))
@@ -407,16 +699,16 @@ Result ChessGame::ParseMoveCommand(
         }
 
         pInputCommand->move.fromIdx           = fromIdx;
-        pInputCommand->move.boardMove.fromPos = fromPos;
-        pInputCommand->move.boardMove.fromPiece = m_board.GetPieceFromPos(fromPos);
+        pInputCommand->move.boardMove.fromIdx = static_cast<uint8>(fromIdx);
+        pInputCommand->move.boardMove.fromPiece = m_board.GetPieceFromIdx(fromIdx);
 
         pInputCommand->move.toIdx           = toIdx;
-        pInputCommand->move.boardMove.toPos = toPos;
-        pInputCommand->move.boardMove.toPiece = m_board.GetPieceFromPos(toPos);
+        pInputCommand->move.boardMove.toIdx = static_cast<uint8>(toIdx);
+        pInputCommand->move.boardMove.toPiece = m_board.GetPieceFromIdx(toIdx);
 
         const Piece fromPiece = pInputCommand->move.boardMove.fromPiece;
         if (((fromPiece == wPawn) || (fromPiece == bPawn))&&
-            toPos == m_board.GetEnPassantPos())
+            pInputCommand->move.boardMove.ToPos() == m_board.GetEnPassantPos())
         {
             pInputCommand->move.boardMove.flags = MoveFlags::EnPassant;
         }
@@ -465,6 +757,11 @@ Result ChessGame::ParseMoveCommand(
             pInputCommand->move.boardMove.flags = MoveFlags::BlackQueenCastle;
             pInputCommand->move.isWhite = false;
         }
+
+        const uint16 castleFlag = pInputCommand->move.boardMove.flags;
+        pInputCommand->move.boardMove.fromIdx = (pInputCommand->move.isWhite) ? WhiteKingStartIdx :
+                                                                                BlackKingStartIdx;
+        pInputCommand->move.boardMove.toIdx   = GetCastleKingLandIdx(castleFlag);
     }
     else
     {
@@ -538,6 +835,7 @@ Result ChessGame::ParsePrintCommand(
     return result;
 }
 
+// perft <depth> [black] [expand] [threads N] [speedup] [hash]
 Result ChessGame::ParsePerftCommand(
     std::vector<std::string> wordVec,
     InputCommand* pInputCommand)
@@ -547,11 +845,32 @@ Result ChessGame::ParsePerftCommand(
     pInputCommand->perft.isWhite = true;
     pInputCommand->perft.depth = UINT32_MAX;
     pInputCommand->perft.expanded = false;
+    pInputCommand->perft.numThreads = 1;
+    pInputCommand->perft.reportSpeedup = false;
+    pInputCommand->perft.useHash = false;
     uint32 size = wordVec.size();
 
     for (uint32 word = 1; word < size; word++)
     {
-        if (wordVec[word].length() == 1)
+        if ((wordVec[word] == "threads") && (word + 1 < size) && IsInteger(wordVec[word + 1]))
+        {
+            word++;
+            pInputCommand->perft.numThreads = std::stoi(wordVec[word]);
+            if ((pInputCommand->perft.numThreads == 0) ||
+                (pInputCommand->perft.numThreads > MaxSearchThreads))
+            {
+                result = Result::ErrorInvalidInput;
+            }
+        }
+        else if (wordVec[word] == "speedup")
+        {
+            pInputCommand->perft.reportSpeedup = true;
+        }
+        else if (wordVec[word] == "hash")
+        {
+            pInputCommand->perft.useHash = true;
+        }
+        else if (wordVec[word].length() == 1)
         {
             pInputCommand->perft.depth = wordVec[word][0] - '0';
         }
@@ -602,6 +921,7 @@ Result ChessGame::ParseEngineCommand(
     pInputCommand->engine.settings.doMove         = false;
     pInputCommand->engine.settings.printStats     = true;
     pInputCommand->engine.settings.useTime        = false;
+    pInputCommand->engine.settings.numThreads     = 1;
     pInputCommand->engine.settings.searchSettings = GetSearchSetting(static_cast<EngineFlags>(EngineFlags::Default));
 
     uint32 size = wordVec.size();
@@ -638,6 +958,20 @@ Result ChessGame::ParseEngineCommand(
         {
             pInputCommand->engine.settings.doMove = true;
         }
+        else if ((wordVec[word] == "threads") && (word + 1 < size) && IsInteger(wordVec[word + 1]))
+        {
+            word++;
+            pInputCommand->engine.settings.numThreads = std::stoi(wordVec[word]);
+            if ((pInputCommand->engine.settings.numThreads == 0) ||
+                (pInputCommand->engine.settings.numThreads > MaxSearchThreads))
+            {
+                result = Result::ErrorInvalidInput;
+            }
+        }
+        else if (wordVec[word] == "speedup")
+        {
+            pInputCommand->engine.reportSpeedup = true;
+        }
         else if (wordVec[word] == "+")
         {
             uint64 engineFlags = 0ull;
@@ -698,9 +1032,9 @@ Result ChessGame::ParseCompareCommand(
     blackEngineSettings.isWhite    = false;
 
     // Input format:
-    // Comapre <timePerMove> <+ whiteFlags [...]> <+ blackFlags [...]>
+    // Comapre <timePerMove> [sharedtt] <+ whiteFlags [...]> <+ blackFlags [...]>
     // the time per move, then a '+', then all of the engine 1 flags, then a '+' then all the
-    // engine2 flags
+    // engine2 flags.  sharedtt has both engines use the same transposition table.
     Result result = Result::Success;
     uint32 vecLen = wordVec.size();
     uint32 curIdx = 1;
@@ -720,6 +1054,13 @@ Result ChessGame::ParseCompareCommand(
     {
         return Result::ErrorInvalidInput;
     }
+    pInputCommand->compare.sharedTT = false;
+    if (wordVec[curIdx] == "sharedtt")
+    {
+        pInputCommand->compare.sharedTT = true;
+        curIdx++;
+    }
+
     if (wordVec[curIdx++] != "+")
     {
         return Result::ErrorInvalidInput;
@@ -759,6 +1100,131 @@ Result ChessGame::ParseCompareCommand(
     return result;
 }
 
+// ttstress [numThreads] [numWalksPerThread]
+Result ChessGame::ParseTTStressCommand(
+    std::vector<std::string> wordVec,
+    InputCommand* pInputCommand)
+{
+    Result result = Result::Success;
+    uint32 vecLen = wordVec.size();
+
+    pInputCommand->ttStress.numThreads = std::max<uint32>(std::thread::hardware_concurrency(), 4);
+    pInputCommand->ttStress.numWalks   = 20000;
+
+    if ((vecLen > 1) && IsInteger(wordVec[1]))
+    {
+        pInputCommand->ttStress.numThreads = std::stoi(wordVec[1]);
+    }
+    else if (vecLen > 1)
+    {
+        result = Result::ErrorInvalidInput;
+    }
+
+    if ((vecLen > 2) && IsInteger(wordVec[2]))
+    {
+        pInputCommand->ttStress.numWalks = std::stoi(wordVec[2]);
+    }
+    else if (vecLen > 2)
+    {
+        result = Result::ErrorInvalidInput;
+    }
+
+    if ((vecLen > 3) ||
+        (pInputCommand->ttStress.numThreads == 0) ||
+        (pInputCommand->ttStress.numThreads > MaxSearchThreads))
+    {
+        result = Result::ErrorInvalidInput;
+    }
+
+    return result;
+}
+
+// hash <sizeMB>
+// evalhash <sizeKB>
+Result ChessGame::ParseHashCommand(
+    std::vector<std::string> wordVec,
+    InputCommand* pInputCommand)
+{
+    Result result = Result::Success;
+
+    if ((wordVec.size() == 2) && IsInteger(wordVec[1]) && (wordVec[1].length() <= 6))
+    {
+        pInputCommand->hash.size = std::stoi(wordVec[1]);
+    }
+    else
+    {
+        result = Result::ErrorInvalidInput;
+    }
+
+    if ((result == Result::Success) && (pInputCommand->hash.size == 0))
+    {
+        result = Result::ErrorInvalidInput;
+    }
+
+    return result;
+}
+
+// perftsuite <file.epd> [depth N] [threads N] [hash]
+Result ChessGame::ParsePerftSuiteCommand(
+    std::vector<std::string> wordVec,
+    const std::string&       caseStr,
+    InputCommand* pInputCommand)
+{
+    Result result = Result::Success;
+    uint32 size = wordVec.size();
+
+    pInputCommand->perftSuite.maxDepth   = UINT32_MAX;
+    pInputCommand->perftSuite.numThreads = 1;
+    pInputCommand->perftSuite.useHash    = false;
+
+    // The file name is the second word of the original input, before it was made lowercase.
+    std::istringstream caseStream(caseStr);
+    std::string        fileName;
+    caseStream >> fileName >> fileName;
+    if ((size < 2) || (fileName.length() >= MaxFileNameLength))
+    {
+        result = Result::ErrorInvalidInput;
+    }
+    else
+    {
+        memcpy(pInputCommand->perftSuite.fileName, fileName.c_str(), fileName.length() + 1);
+    }
+
+    for (uint32 word = 2; (word < size) && (result == Result::Success); word++)
+    {
+        if ((wordVec[word] == "depth") && (word + 1 < size) && IsInteger(wordVec[word + 1]))
+        {
+            word++;
+            pInputCommand->perftSuite.maxDepth = std::stoi(wordVec[word]);
+            if ((pInputCommand->perftSuite.maxDepth == 0) ||
+                (pInputCommand->perftSuite.maxDepth >= MaxEngineDepth))
+            {
+                result = Result::ErrorInvalidInput;
+            }
+        }
+        else if ((wordVec[word] == "threads") && (word + 1 < size) && IsInteger(wordVec[word + 1]))
+        {
+            word++;
+            pInputCommand->perftSuite.numThreads = std::stoi(wordVec[word]);
+            if ((pInputCommand->perftSuite.numThreads == 0) ||
+                (pInputCommand->perftSuite.numThreads > MaxSearchThreads))
+            {
+                result = Result::ErrorInvalidInput;
+            }
+        }
+        else if (wordVec[word] == "hash")
+        {
+            pInputCommand->perftSuite.useHash = true;
+        }
+        else
+        {
+            result = Result::ErrorInvalidInput;
+        }
+    }
+
+    return result;
+}
+
 Result ChessGame::ParseResetCommand(
     std::vector<std::string> wordVec,
     InputCommand* pInputCommand)
@@ -827,5 +1293,67 @@ Result ChessGame::ParseResetCommand(
     {
         result = Result::ErrorInvalidInput;
     }
+    return result;
+}
+
+// evaluator <hce|nnue>
+Result ChessGame::ParseEvaluatorCommand(
+    std::vector<std::string> wordVec,
+    InputCommand* pInputCommand)
+{
+    Result result = Result::Success;
+
+    if ((wordVec.size() == 2) && ((wordVec[1] == "hce") || (wordVec[1] == "nnue")))
+    {
+        pInputCommand->evaluator.useNnue = (wordVec[1] == "nnue");
+    }
+    else
+    {
+        result = Result::ErrorInvalidInput;
+    }
+
+    return result;
+}
+
+// numa on|off
+Result ChessGame::ParseNumaCommand(
+    std::vector<std::string> wordVec,
+    InputCommand* pInputCommand)
+{
+    Result result = Result::Success;
+
+    if ((wordVec.size() == 2) && ((wordVec[1] == "on") || (wordVec[1] == "off")))
+    {
+        pInputCommand->numa.interleave = (wordVec[1] == "on");
+    }
+    else
+    {
+        result = Result::ErrorInvalidInput;
+    }
+
+    return result;
+}
+
+// evalfile <file>
+Result ChessGame::ParseEvalFileCommand(
+    std::vector<std::string> wordVec,
+    const std::string&       caseStr,
+    InputCommand* pInputCommand)
+{
+    Result result = Result::Success;
+
+    // Same as perftsuite, the file name is taken from the input before it was made lowercase.
+    std::istringstream caseStream(caseStr);
+    std::string        fileName;
+    caseStream >> fileName >> fileName;
+    if ((wordVec.size() != 2) || (fileName.length() >= MaxFileNameLength))
+    {
+        result = Result::ErrorInvalidInput;
+    }
+    else
+    {
+        memcpy(pInputCommand->evalFile.fileName, fileName.c_str(), fileName.length() + 1);
+    }
+
     return result;
 }
\ No newline at end of file
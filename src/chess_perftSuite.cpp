@@ -0,0 +1,221 @@
+#include "../inc/board.h"
+#include "../inc/chess.h"
+#include "../inc/engine.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+struct PerftSuiteEntry
+{
+    std::string fenStr;
+    uint32      depth;
+    uint64      expected;
+};
+
+enum class PerftSuiteLine : uint32
+{
+    Entry,          // Has a count to check
+    Ignored,        // Blank or a comment
+    NoCountAtDepth, // Only has counts deeper than maxDepth
+    Malformed,
+};
+
+// EPD perft lines look like "<fen> ;D1 20 ;D2 400 ;D3 8902".  Picks the deepest count at or below
+// maxDepth.  Any field that isn't a depth and a count makes the whole line malformed, so a typo in
+// an expectation can't quietly drop it from the suite.
+static PerftSuiteLine ParsePerftSuiteLine(const std::string& line,
+                                          uint32             maxDepth,
+                                          PerftSuiteEntry*   pEntry)
+{
+    const size_t firstChar = line.find_first_not_of(" \t\r");
+    if ((firstChar == std::string::npos) || (line[firstChar] == '#'))
+    {
+        return PerftSuiteLine::Ignored;
+    }
+
+    const size_t firstSemicolon = line.find(';');
+    if (firstSemicolon == std::string::npos)
+    {
+        return PerftSuiteLine::Malformed;
+    }
+
+    pEntry->fenStr   = line.substr(0, firstSemicolon);
+    pEntry->depth    = 0;
+    pEntry->expected = 0ull;
+
+    // SetBoardFromFEN stops on whitespace, but not on a trailing space after the last field.
+    pEntry->fenStr.erase(pEntry->fenStr.find_last_not_of(" \t") + 1);
+    if (pEntry->fenStr.find_first_not_of(" \t") == std::string::npos)
+    {
+        return PerftSuiteLine::Malformed;
+    }
+
+    uint32 numCounts = 0;
+
+    std::istringstream fieldStream(line.substr(firstSemicolon + 1));
+    std::string        field;
+    while (std::getline(fieldStream, field, ';'))
+    {
+        std::istringstream depthStream(field);
+        std::string        depthTag;
+        std::string        countStr;
+        std::string        extraStr;
+        depthStream >> depthTag >> countStr >> extraStr;
+
+        // Nothing between two semicolons, or after the last one.
+        if (depthTag.length() == 0)
+        {
+            continue;
+        }
+
+        const bool isDepthTag = (depthTag.length() > 1)                         &&
+                                (depthTag.length() <= 3)                        &&
+                                ((depthTag[0] == 'D') || (depthTag[0] == 'd'))  &&
+                                IsInteger(depthTag.substr(1))                   &&
+                                (countStr.length() > 0)                         &&
+                                (countStr.length() <= 19)                       &&
+                                IsInteger(countStr)                             &&
+                                (extraStr.length() == 0);
+        if (isDepthTag == false)
+        {
+            return PerftSuiteLine::Malformed;
+        }
+
+        const uint32 depth = std::stoul(depthTag.substr(1));
+        if ((depth == 0) || (depth >= MaxEngineDepth))
+        {
+            return PerftSuiteLine::Malformed;
+        }
+
+        numCounts++;
+        if ((depth <= maxDepth) && (depth > pEntry->depth))
+        {
+            pEntry->depth    = depth;
+            pEntry->expected = std::stoull(countStr);
+        }
+    }
+
+    if (numCounts == 0)
+    {
+        return PerftSuiteLine::Malformed;
+    }
+    return (pEntry->depth > 0) ? PerftSuiteLine::Entry : PerftSuiteLine::NoCountAtDepth;
+}
+
+// The board is put back the way it was once the suite is done, so this can be run from the middle
+// of a game.
+Result ChessGame::DoPerftSuite(const char* pFileName, uint32 maxDepth, uint32 numThreads, bool useHash)
+{
+    std::ifstream suiteFile(pFileName);
+    if (suiteFile.is_open() == false)
+    {
+        std::cout << "Couldn't open " << pFileName << std::endl;
+        return Result::ErrorInvalidInput;
+    }
+
+    BoardSnapshot savedBoard;
+    m_board.SaveSnapshot(&savedBoard);
+
+    // A depth 1 count is just move generation, but it allocates the perft table so that isn't timed
+    // as part of the first position.
+    m_engine.CountPerft(1, numThreads, useHash);
+
+    uint32 numPassed      = 0;
+    uint32 numFailed      = 0;
+    uint32 numMalformed   = 0;
+    uint32 numSkipped     = 0;
+    uint64 totalPositions = 0ull;
+    auto   totalTime      = TimeType(0);
+
+    std::cout << "  #  Depth          Expected             Nodes    Time ms      Mnps  Result"
+              << std::endl;
+
+    std::string line;
+    uint32      lineNum = 0;
+    while (std::getline(suiteFile, line))
+    {
+        lineNum++;
+
+        PerftSuiteEntry entry = {};
+        const PerftSuiteLine lineType = ParsePerftSuiteLine(line, maxDepth, &entry);
+        if (lineType == PerftSuiteLine::Malformed)
+        {
+            numMalformed++;
+            std::cout << std::setw(3) << lineNum << "  MALFORMED  " << line << std::endl;
+            continue;
+        }
+        else if (lineType == PerftSuiteLine::NoCountAtDepth)
+        {
+            numSkipped++;
+            std::cout << std::setw(3) << lineNum << "  skipped, no count at depth " << maxDepth
+                      << " or below" << std::endl;
+            continue;
+        }
+        else if (lineType == PerftSuiteLine::Ignored)
+        {
+            continue;
+        }
+
+        m_board.SetBoardFromFEN(entry.fenStr);
+
+        auto startTime = std::chrono::steady_clock::now();
+        const uint64 positions = m_engine.CountPerft(entry.depth, numThreads, useHash);
+        auto endTime   = std::chrono::steady_clock::now();
+
+        const TimeType runTime = std::chrono::duration_cast<TimeType>(endTime - startTime);
+        const bool     passed  = (positions == entry.expected);
+        const double   mnps    = static_cast<double>(positions) /
+                                 (std::max<int64>(runTime.count(), 1) * 1000.0);
+
+        numPassed      += passed ? 1 : 0;
+        numFailed      += passed ? 0 : 1;
+        totalPositions += positions;
+        totalTime      += runTime;
+
+        std::cout << std::setw(3)  << lineNum
+                  << std::setw(7)  << entry.depth
+                  << std::setw(18) << entry.expected
+                  << std::setw(18) << positions
+                  << std::setw(11) << runTime.count()
+                  << std::setw(10) << std::fixed << std::setprecision(2) << mnps
+                  << (passed ? "  pass" : "  FAIL") << std::endl;
+        if (passed == false)
+        {
+            std::cout << "     " << entry.fenStr << std::endl;
+        }
+    }
+
+    m_board.RestoreSnapshot(savedBoard);
+
+    const double totalMnps = static_cast<double>(totalPositions) /
+                             (std::max<int64>(totalTime.count(), 1) * 1000.0);
+
+    std::cout << "Passed            : " << numPassed << "/" << numPassed + numFailed << std::endl;
+    if ((numMalformed > 0) || (numSkipped > 0))
+    {
+        std::cout << "Malformed lines   : " << numMalformed << std::endl;
+        std::cout << "Skipped lines     : " << numSkipped << std::endl;
+    }
+    std::cout << "Positions searched: " << totalPositions << std::endl;
+    std::cout << "Time              : " << totalTime.count() << " ms" << std::endl;
+    std::cout << "Mnps              : " << std::fixed << std::setprecision(2) << totalMnps
+              << std::endl;
+    std::cout << std::defaultfloat;
+
+    // A malformed line is an expectation that wasn't checked, so it fails the suite the same as a
+    // wrong count.  A file with nothing to check at this depth didn't fail anything, the suite
+    // just couldn't be run.
+    if ((numFailed > 0) || (numMalformed > 0))
+    {
+        return Result::Error;
+    }
+    else if (numPassed == 0)
+    {
+        std::cout << "No counts at depth " << maxDepth << " or below to check" << std::endl;
+        return Result::ErrorInvalidInput;
+    }
+    return Result::Success;
+}
@@ -0,0 +1,345 @@
+#include "../inc/board.h"
+#include "../inc/chess.h"
+#include "../inc/engine.h"
+#include "../inc/engineSettings.h"
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+// Unlike the REPL, nothing here is lowercased, fens are case sensitive.
+static std::vector<std::string> SplitUciLine(const std::string& line)
+{
+    std::istringstream       strStream(line);
+    std::vector<std::string> words;
+
+    std::string word;
+    while (strStream >> word)
+    {
+        words.push_back(word);
+    }
+    return words;
+}
+
+static void PrintUciId()
+{
+    std::cout << "id name chess_cpp" << std::endl;
+    std::cout << "id author connorgre" << std::endl;
+    std::cout << "option name Hash type spin default " << DefaultTransTableSizeMB
+              << " min 1 max " << UciMaxHashMB << std::endl;
+    std::cout << "option name EvalHashKB type spin default " << DefaultEvalCacheSizeKB
+              << " min 1 max " << UciMaxEvalHashKB << std::endl;
+    std::cout << "option name Threads type spin default 1 min 1 max " << MaxSearchThreads
+              << std::endl;
+    std::cout << "option name EvalFile type string default " << DefaultNnueFileName << std::endl;
+    std::cout << "option name UseNNUE type check default true" << std::endl;
+    std::cout << "option name NumaInterleave type check default "
+              << (DefaultInterleaveTransTables ? "true" : "false") << std::endl;
+    std::cout << "uciok" << std::endl;
+}
+
+void ChessGame::RunUci()
+{
+    PrintUciId();
+
+    bool running = true;
+    while (running)
+    {
+        std::string inputLine;
+        if (!std::getline(std::cin, inputLine))
+        {
+            break;
+        }
+
+        const std::vector<std::string> wordVec = SplitUciLine(inputLine);
+        if (wordVec.size() == 0)
+        {
+            continue;
+        }
+
+        const std::string& command = wordVec[0];
+        if (command == "uci")
+        {
+            PrintUciId();
+        }
+        else if (command == "isready")
+        {
+            std::cout << "readyok" << std::endl;
+        }
+        else if (command == "ucinewgame")
+        {
+            UciStopSearch();
+            m_engine.ResetTransTable();
+            m_engine.ResetKillers();
+        }
+        else if (command == "position")
+        {
+            UciStopSearch();
+            UciPosition(wordVec);
+        }
+        else if (command == "go")
+        {
+            UciGo(wordVec);
+        }
+        else if (command == "stop")
+        {
+            UciStopSearch();
+        }
+        else if (command == "setoption")
+        {
+            UciStopSearch();
+            UciSetOption(wordVec);
+        }
+        else if (command == "quit")
+        {
+            running = false;
+        }
+    }
+
+    UciStopSearch();
+}
+
+// position [startpos | fen <fen>] [moves <move> ...]
+void ChessGame::UciPosition(const std::vector<std::string>& wordVec)
+{
+    const uint32 vecLen = wordVec.size();
+
+    uint32 idx = 1;
+    if ((idx < vecLen) && (wordVec[idx] == "startpos"))
+    {
+        m_board.ResetBoard();
+        idx++;
+    }
+    else if ((idx < vecLen) && (wordVec[idx] == "fen"))
+    {
+        idx++;
+        std::string fenStr = "";
+        while ((idx < vecLen) && (wordVec[idx] != "moves"))
+        {
+            fenStr += wordVec[idx] + " ";
+            idx++;
+        }
+        m_board.SetBoardFromFEN(fenStr);
+    }
+
+    if ((idx < vecLen) && (wordVec[idx] == "moves"))
+    {
+        idx++;
+    }
+
+    // Playing the moves out, instead of setting the final position, is what gives the board the
+    // history it needs to see repetitions.
+    for (; idx < vecLen; idx++)
+    {
+        Move move = {};
+        if (m_engine.GetMoveFromString(wordVec[idx], &move) == false)
+        {
+            std::cout << "info string illegal move " << wordVec[idx] << std::endl;
+            break;
+        }
+
+        if (m_board.GetBoardStateIsWhiteTurn())
+        {
+            m_board.MakeMove<true>(move);
+        }
+        else
+        {
+            m_board.MakeMove<false>(move);
+        }
+    }
+}
+
+// go [depth N] [movetime ms] [wtime ms] [btime ms] [winc ms] [binc ms] [movestogo N] [nodes N]
+//    [infinite]
+void ChessGame::UciGo(const std::vector<std::string>& wordVec)
+{
+    UciStopSearch();
+
+    const bool isWhite = m_board.GetBoardStateIsWhiteTurn();
+
+    EngineSettings settings = {};
+    settings.isWhite        = isWhite;
+    settings.depth          = MaxEngineDepth;
+    settings.useTime        = false;
+    settings.doMove         = false;
+    settings.printStats     = false;
+    settings.printUciInfo   = true;
+    settings.numThreads     = m_uciNumThreads;
+    settings.searchSettings = GetSearchSetting(EngineFlags::Default);
+
+    uint64 moveTime  = 0;
+    uint64 timeLeft  = 0;
+    uint64 increment = 0;
+    uint64 movesToGo = 0;
+    bool   infinite  = false;
+
+    const uint32 vecLen = wordVec.size();
+    for (uint32 idx = 1; idx < vecLen; idx++)
+    {
+        const std::string& word     = wordVec[idx];
+        const bool         hasValue = (idx + 1 < vecLen) && IsInteger(wordVec[idx + 1]);
+        const uint64       value    = hasValue ? std::stoull(wordVec[idx + 1]) : 0;
+
+        // IterativeDeepening stops before it gets to the depth it's given.
+        if      ((word == "depth")     && hasValue) { settings.depth    = value + 1;  }
+        else if ((word == "movetime")  && hasValue) { moveTime          = value;      }
+        else if ((word == "nodes")     && hasValue) { settings.maxNodes = value;      }
+        else if ((word == "movestogo") && hasValue) { movesToGo         = value;      }
+        else if ((word == "wtime")     && hasValue) { timeLeft  = isWhite ? value : timeLeft;  }
+        else if ((word == "btime")     && hasValue) { timeLeft  = isWhite ? timeLeft : value;  }
+        else if ((word == "winc")      && hasValue) { increment = isWhite ? value : increment; }
+        else if ((word == "binc")      && hasValue) { increment = isWhite ? increment : value; }
+        else if (word == "infinite")                { infinite          = true;       }
+    }
+    settings.depth = std::min<uint32>(settings.depth, MaxEngineDepth);
+
+    // IterativeDeepening won't start another depth after 70% of the time, the timer thread is
+    // what actually stops a depth that runs long.
+    TimeType searchTime = TimeType(0);
+    if (moveTime > 0)
+    {
+        searchTime = TimeType(moveTime);
+    }
+    else if (timeLeft > 0)
+    {
+        const uint64 movesLeft = (movesToGo > 0) ? movesToGo : UciDefaultMovesToGo;
+        uint64 allotted = (timeLeft / movesLeft) + ((increment * 3) / 4);
+        allotted = std::min(allotted, timeLeft / 2);
+        allotted = (allotted > UciMoveOverheadMs) ? (allotted - UciMoveOverheadMs) : 1;
+        searchTime = TimeType(allotted);
+    }
+
+    if ((searchTime.count() > 0) && (infinite == false))
+    {
+        settings.useTime = true;
+        settings.time    = searchTime;
+    }
+
+    m_uciStop.store(false);
+    m_uciSearchDone.store(false);
+
+    m_uciSearchThread = std::thread([this, settings, infinite]()
+        {
+            std::thread timeOutThread;
+            if (settings.useTime)
+            {
+                timeOutThread = std::thread([this, settings]()
+                    {
+                        const auto deadline = std::chrono::steady_clock::now() + settings.time;
+                        while ((m_uciSearchDone.load(std::memory_order_relaxed) == false) &&
+                               (std::chrono::steady_clock::now() < deadline))
+                        {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                        }
+                        m_uciStop.store(true);
+                    });
+            }
+
+            Move bestMove = m_engine.DoEngine(settings, m_uciStop);
+            m_uciSearchDone.store(true);
+
+            if (timeOutThread.joinable())
+            {
+                timeOutThread.join();
+            }
+
+            // "go infinite" isn't allowed to answer until the GUI sends stop, even if the search
+            // ran out of depth first.
+            while (infinite && (m_uciStop.load(std::memory_order_relaxed) == false))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            const std::string moveStr = bestMove.IsNull() ?
+                                        "0000" : m_board.GetStringFromMove(bestMove);
+            std::cout << "bestmove " << moveStr << std::endl;
+        });
+}
+
+// setoption name <name> value <value>
+void ChessGame::UciSetOption(const std::vector<std::string>& wordVec)
+{
+    std::string name     = "";
+    std::string valueStr = "";
+
+    const uint32 vecLen = wordVec.size();
+    for (uint32 idx = 1; idx + 1 < vecLen; idx++)
+    {
+        if (wordVec[idx] == "name")
+        {
+            name = wordVec[idx + 1];
+        }
+        else if (wordVec[idx] == "value")
+        {
+            valueStr = wordVec[idx + 1];
+        }
+    }
+
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    // The options that aren't numbers.
+    if (name == "evalfile")
+    {
+        if (LoadNnueFile(valueStr.c_str()) == false)
+        {
+            std::cout << "info string couldn't load " << valueStr << std::endl;
+        }
+        return;
+    }
+    else if (name == "usennue")
+    {
+        m_useNnue = (valueStr == "true");
+        SelectEvaluator();
+        return;
+    }
+    else if (name == "numainterleave")
+    {
+        m_interleaveNuma = (valueStr == "true");
+        if (ReallocTransTables() == false)
+        {
+            std::cout << "info string hash is " << m_transTableSizeMB << " MB" << std::endl;
+        }
+        return;
+    }
+
+    if ((valueStr.length() == 0) || (valueStr.length() > 9) || (IsInteger(valueStr) == false))
+    {
+        std::cout << "info string bad value for " << name << std::endl;
+        return;
+    }
+
+    const uint32 value = std::stoul(valueStr);
+    if (name == "hash")
+    {
+        const uint32 sizeMB = std::clamp<uint32>(value, 1, UciMaxHashMB);
+        m_transTableSizeMB  = sizeMB;
+        if (ReallocTransTables() == false)
+        {
+            std::cout << "info string couldn't allocate " << sizeMB << " MB hash, it is "
+                      << m_transTableSizeMB << " MB" << std::endl;
+        }
+    }
+    else if (name == "evalhashkb")
+    {
+        m_evalCacheSizeKB = std::clamp<uint32>(value, 1, UciMaxEvalHashKB);
+        m_engine.SetEvalCacheSizeKB(m_evalCacheSizeKB);
+    }
+    else if (name == "threads")
+    {
+        m_uciNumThreads = std::clamp<uint32>(value, 1, MaxSearchThreads);
+    }
+    else
+    {
+        std::cout << "info string unknown option " << name << std::endl;
+    }
+}
+
+void ChessGame::UciStopSearch()
+{
+    if (m_uciSearchThread.joinable())
+    {
+        m_uciStop.store(true);
+        m_uciSearchThread.join();
+    }
+}
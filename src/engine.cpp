@@ -5,6 +5,7 @@
 
 #include <chrono>
 #include <atomic>
+#include <algorithm>
 
 ChessEngine::ChessEngine()
 :
@@ -12,10 +13,18 @@ m_pBoard(nullptr),
 m_pppMoveLists(nullptr),
 m_searchValues({}),
 m_counterMoveTable(),
-m_pMainSearchTransTable(nullptr),
-m_pQSearchTransTable(nullptr),
-m_engineMainTTs(),
-m_engineQSearchTTs()
+m_transTable(),
+m_pTransTable(nullptr),
+m_perftTable(),
+m_pPerftTable(nullptr),
+m_evalCache(),
+m_pEvalCache(nullptr),
+m_pawnHashTable(),
+m_helperEngines(),
+m_helperBoard(),
+m_threadIdx(0),
+m_maxNodes(UINT64_MAX),
+m_printUciInfo(false)
 {
 
 }
@@ -28,6 +37,40 @@ ChessEngine::~ChessEngine()
 void ChessEngine::Init(Board* pBoard)
 {
     m_pBoard = pBoard;
+    InitMoveLists();
+
+    m_transTable.Init(DefaultTransTableSizeMB, DefaultInterleaveTransTables);
+    m_pTransTable = &m_transTable;
+
+    m_evalCache.Init(DefaultEvalCacheSizeKB);
+    m_pEvalCache = &m_evalCache;
+
+    m_pawnHashTable.Init(DefaultPawnHashTableEntries);
+
+    PrintTransTableMemory();
+}
+
+// Large pages can quietly fall back to normal ones, which costs a lot of speed on big tables.
+void ChessEngine::PrintTransTableMemory()
+{
+    std::cout << "TransTable memory  : " << m_transTable.GetSizeMB() << " MB, "
+              << m_transTable.GetAllocModeStr() << ", "
+              << m_transTable.GetNumaNodes() << " NUMA node(s)" << std::endl;
+}
+
+// Helpers don't own a transposition table or eval cache, the main engine points them at its own
+// before every search.
+void ChessEngine::InitHelper(uint32 threadIdx)
+{
+    m_pBoard    = &m_helperBoard;
+    m_threadIdx = threadIdx;
+    InitMoveLists();
+
+    m_pawnHashTable.Init(DefaultPawnHashTableEntries);
+}
+
+void ChessEngine::InitMoveLists()
+{
     m_pppMoveLists = new Move** [MaxEngineDepth];
 
     for (uint32 i = 0; i < MaxEngineDepth; i++)
@@ -59,18 +102,27 @@ void ChessEngine::Init(Board* pBoard)
             m_pppMoveLists[i][Normal][j].fromPiece = Piece::EndOfMoveList;
         }
     }
+}
 
-    m_engineMainTTs[0].Init(MainTransTableSize);
-    m_engineMainTTs[1].Init(MainTransTableSize);
+void ChessEngine::Destroy()
+{
+    for (ChessEngine* pHelper : m_helperEngines)
+    {
+        pHelper->DestroyMoveLists();
+        pHelper->m_pawnHashTable.Destroy();
+        delete pHelper;
+    }
+    m_helperEngines.clear();
 
-    m_engineQSearchTTs[0].Init(QSearchTransTableSize);
-    m_engineQSearchTTs[1].Init(QSearchTransTableSize);
+    DestroyMoveLists();
 
-    m_pMainSearchTransTable = &(m_engineMainTTs[0]);
-    m_pQSearchTransTable    = &(m_engineQSearchTTs[0]);
+    m_transTable.Destroy();
+    m_perftTable.Destroy();
+    m_evalCache.Destroy();
+    m_pawnHashTable.Destroy();
 }
 
-void ChessEngine::Destroy()
+void ChessEngine::DestroyMoveLists()
 {
     for (uint32 i = 0; i < MaxEngineDepth; i++)
     {
@@ -83,11 +135,6 @@ void ChessEngine::Destroy()
     delete[] m_pppMoveLists;
 
     m_pppMoveLists = nullptr;
-
-    m_engineMainTTs[0].Destroy();
-    m_engineMainTTs[1].Destroy();
-    m_engineQSearchTTs[0].Destroy();
-    m_engineQSearchTTs[1].Destroy();
 }
 
 Move ChessEngine::DoEngine(EngineSettings     settings,
@@ -96,6 +143,11 @@ Move ChessEngine::DoEngine(EngineSettings     settings,
                            bool*              pIsMoveLegal)
 {
     m_searchValues = {};
+    m_maxNodes     = (settings.maxNodes == 0) ? UINT64_MAX : settings.maxNodes;
+    m_printUciInfo = settings.printUciInfo;
+
+    m_pBoard->SetPawnHashTable(&m_pawnHashTable);
+    m_pawnHashTable.ResetStats();
 
     Move bestMove = {};
     auto startTime = std::chrono::steady_clock::now();
@@ -106,8 +158,6 @@ Move ChessEngine::DoEngine(EngineSettings     settings,
     // Make a null move to trade turns to keep the board state consistent
     if (settings.isWhite)
     {
-        m_pMainSearchTransTable = &(m_engineMainTTs[0]);
-        m_pQSearchTransTable    = &(m_engineQSearchTTs[0]);
         if (m_pBoard->GetBoardStateIsWhiteTurn() == false)
         {
             std::cout << "Making null move to switch team (black->white)" << std::endl;
@@ -116,9 +166,6 @@ Move ChessEngine::DoEngine(EngineSettings     settings,
     }
     else
     {
-        m_pMainSearchTransTable = &(m_engineMainTTs[1]);
-        m_pQSearchTransTable = &(m_engineQSearchTTs[1]);
-
         if (m_pBoard->GetBoardStateIsWhiteTurn() == true)
         {
             std::cout << "Making null move to switch team (white->black)" << std::endl;
@@ -126,8 +173,16 @@ Move ChessEngine::DoEngine(EngineSettings     settings,
         }
     }
 
+    // Age everything from earlier searches, so it's the first to go when the table fills up.
+    m_pTransTable->NewSearch();
+
+    // The helpers have to copy the board after the null move above, so they search the same root.
+    std::atomic<bool>        stopHelpers = false;
+    std::vector<std::thread> helperThreads;
+
     if (settings.isWhite)
     {
+        StartHelperThreads<true>(settings, stopHelpers, &helperThreads);
         bestMove = IterativeDeepening<true>(settings.depth,
                                             settings.time,
                                             settings.useTime,
@@ -135,7 +190,15 @@ Move ChessEngine::DoEngine(EngineSettings     settings,
                                             isTimedOut,
                                             &maxDepth);
 
-        isMoveLegal = m_pBoard->IsMoveLegal<true, true>(bestMove);
+        stopHelpers.store(true);
+        for (std::thread& helperThread : helperThreads)
+        {
+            helperThread.join();
+        }
+
+        // The reasons a move is illegal aren't UCI lines, so they're only printed outside of it.
+        isMoveLegal = (settings.printUciInfo) ? m_pBoard->IsMoveLegal<true, false>(bestMove) :
+                                                m_pBoard->IsMoveLegal<true, true>(bestMove);
         if (settings.doMove && isMoveLegal)
         {
             m_pBoard->MakeMove<true>(bestMove);
@@ -143,6 +206,7 @@ Move ChessEngine::DoEngine(EngineSettings     settings,
     }
     else
     {
+        StartHelperThreads<false>(settings, stopHelpers, &helperThreads);
         bestMove = IterativeDeepening<false>(settings.depth,
                                              settings.time,
                                              settings.useTime,
@@ -150,7 +214,14 @@ Move ChessEngine::DoEngine(EngineSettings     settings,
                                              isTimedOut,
                                              &maxDepth);
 
-        isMoveLegal = m_pBoard->IsMoveLegal<false, true>(bestMove);
+        stopHelpers.store(true);
+        for (std::thread& helperThread : helperThreads)
+        {
+            helperThread.join();
+        }
+
+        isMoveLegal = (settings.printUciInfo) ? m_pBoard->IsMoveLegal<false, false>(bestMove) :
+                                                m_pBoard->IsMoveLegal<false, true>(bestMove);
         if (settings.doMove && isMoveLegal)
         {
             m_pBoard->MakeMove<false>(bestMove);
@@ -160,7 +231,7 @@ Move ChessEngine::DoEngine(EngineSettings     settings,
         bestMove.score *= -1;
     }
 
-    if ((pIsMoveLegal != nullptr) && (bestMove.fromPos != 0ull))
+    if ((pIsMoveLegal != nullptr) && (bestMove.IsNull() == false))
     {
         *pIsMoveLegal = isMoveLegal;
     }
@@ -170,12 +241,21 @@ Move ChessEngine::DoEngine(EngineSettings     settings,
         auto endTime = std::chrono::steady_clock::now();
         auto totalTime = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
 
-        uint32 knps = 0;
+        const uint64 totalPositions = GetPositionsSearched();
+
+        uint32 knps      = 0;
+        uint32 totalKnps = 0;
         if (totalTime.count() > 0)
         {
-            knps = m_searchValues.positionsSearched / totalTime.count();
+            knps      = m_searchValues.positionsSearched / totalTime.count();
+            totalKnps = totalPositions / totalTime.count();
         }
 
+        // Whole percent, rounded down, so a 99.9% hit rate doesn't print as 100.
+        const uint64 pawnHashProbes  = m_pawnHashTable.GetNumProbes();
+        const uint64 pawnHashHitRate = (pawnHashProbes == 0ull) ? 0ull :
+                                       (m_pawnHashTable.GetNumHits() * 100) / pawnHashProbes;
+
         std::string bestMoveStr = m_pBoard->GetStringFromMove(bestMove);
         std::string scoreStr = ConvertScoreToStr(bestMove.score);
 
@@ -185,11 +265,23 @@ Move ChessEngine::DoEngine(EngineSettings     settings,
         std::cout << "Time               : " << totalTime.count() << " ms" << std::endl;
         std::cout << "Positions searched : " << m_searchValues.positionsSearched << std::endl;
         std::cout << "Knps               : " << knps << std::endl;
+        if (helperThreads.size() > 0)
+        {
+            std::cout << "Threads            : " << helperThreads.size() + 1 << std::endl;
+            std::cout << "Total positions    : " << totalPositions << std::endl;
+            std::cout << "Total Knps         : " << totalKnps << std::endl;
+        }
 
         std::cout << "Normal Searched       : " << m_searchValues.normalSearched      << std::endl;
         std::cout << "Quiscence searched    : " << m_searchValues.quiscenceSearched   << std::endl;
         std::cout << "TransTable hits       : " << m_searchValues.mainTransTableHits  << std::endl;
         std::cout << "QSearch TT hits       : " << m_searchValues.qTransTableHits     << std::endl;
+        std::cout << "TransTable hashfull   : " << m_pTransTable->GetHashFull()       << std::endl;
+        std::cout << "Evaluator             : " << (m_pBoard->UsesNnue() ? "nnue" : "hce") << std::endl;
+        std::cout << "Eval cache hits       : " << m_searchValues.evalCacheHits       << std::endl;
+        std::cout << "Eval cache misses     : " << m_searchValues.evalCacheMisses     << std::endl;
+        std::cout << "Lazy eval exits       : " << m_searchValues.lazyEvalExits       << std::endl;
+        std::cout << "Pawn hash hit rate    : " << pawnHashHitRate << "%"             << std::endl;
         std::cout << "Null Move Prunes      : " << m_searchValues.nullMoveCutoffs     << std::endl;
         std::cout << "Null Move Reductions  : " << m_searchValues.numNullReductions   << std::endl;
         std::cout << "Futility Prunes       : " << m_searchValues.futilityCutoffs     << std::endl;
@@ -212,24 +304,463 @@ Move ChessEngine::DoEngine(EngineSettings     settings,
     return bestMove;
 }
 
-void ChessEngine::DoPerft(uint32 depth, bool isWhite, bool expanded)
+// Lazy SMP.  Every helper searches the same root as the main thread on its own copy of the board,
+// and the only thing they share is the transposition tables.  The helpers never return a move,
+// what they add is all the TT entries they leave behind, which let the main thread cut off or
+// order moves in parts of the tree it hasn't gotten to yet.  Odd helpers start a ply deeper so the
+// threads don't all spend their time on the same depth.
+template<bool isWhite>
+void ChessEngine::StartHelperThreads(
+    const EngineSettings&     settings,
+    std::atomic<bool>&        stopHelpers,
+    std::vector<std::thread>* pHelperThreads)
 {
-    m_searchValues.positionsSearched = 0ull;
+    const uint32 numThreads = std::min(std::max<uint32>(settings.numThreads, 1), MaxSearchThreads);
+    const uint32 numHelpers = numThreads - 1;
+
+    CreateHelperEngines(numHelpers);
+
+    for (uint32 helperIdx = 0; helperIdx < m_helperEngines.size(); helperIdx++)
+    {
+        m_helperEngines[helperIdx]->m_searchValues = {};
+    }
+
+    for (uint32 helperIdx = 0; helperIdx < numHelpers; helperIdx++)
+    {
+        ChessEngine* pHelper = m_helperEngines[helperIdx];
+
+        pHelper->m_helperBoard = *m_pBoard;
+        pHelper->m_pTransTable = m_pTransTable;
+        pHelper->m_pEvalCache  = m_pEvalCache;
+        pHelper->m_helperBoard.SetPawnHashTable(&pHelper->m_pawnHashTable);
+
+        // Helpers keep going until the main thread is done, so they ignore the depth and time
+        // limits.
+        pHelperThreads->emplace_back([pHelper, settings, &stopHelpers]()
+            {
+                pHelper->IterativeDeepening<isWhite>(MaxEngineDepth,
+                                                     settings.time,
+                                                     false,
+                                                     settings.searchSettings,
+                                                     stopHelpers);
+            });
+    }
+}
+
+void ChessEngine::CreateHelperEngines(uint32 numHelpers)
+{
+    while (m_helperEngines.size() < numHelpers)
+    {
+        ChessEngine* pHelper = new ChessEngine();
+        pHelper->InitHelper(static_cast<uint32>(m_helperEngines.size()) + 1);
+        m_helperEngines.push_back(pHelper);
+    }
+}
+
+uint64 ChessEngine::GetPositionsSearched()
+{
+    uint64 positionsSearched = m_searchValues.positionsSearched;
+    for (ChessEngine* pHelper : m_helperEngines)
+    {
+        positionsSearched += pHelper->m_searchValues.positionsSearched;
+    }
+    return positionsSearched;
+}
+
+// Ties the score stored with a move to the key it was stored under, so a probe that returns data
+// from a different position can be caught even if the move happens to be legal here too.
+static int32 GetTTStressTestScore(uint64 zobKey)
+{
+    return static_cast<int32>(zobKey & 0x3FFF);
+}
+
+bool ChessEngine::DoTTStressTest(uint32 numThreads, uint32 numWalks)
+{
+    // The walks all start from the same position, so the threads are constantly overwriting the
+    // entries the others are reading near the root.  The table is kept small so different keys
+    // fight over buckets deeper in the walks too.
+    constexpr uint32 StressTableSizeMB = 1;
+    constexpr uint32 StressWalkDepth   = 8;
+
+    numThreads = std::min(std::max<uint32>(numThreads, 1), MaxSearchThreads);
+
+    TranspositionTable stressTable;
+    stressTable.Init(StressTableSizeMB);
+
+    CreateHelperEngines(numThreads);
+
+    const bool isWhite = m_pBoard->GetBoardStateIsWhiteTurn();
+
+    std::vector<uint64>      numHits(numThreads, 0ull);
+    std::vector<uint64>      numBadHits(numThreads, 0ull);
+    std::vector<std::thread> stressThreads;
+
     auto startTime = std::chrono::steady_clock::now();
 
-    if (expanded)
+    for (uint32 threadIdx = 0; threadIdx < numThreads; threadIdx++)
+    {
+        ChessEngine* pHelper = m_helperEngines[threadIdx];
+        pHelper->m_helperBoard = *m_pBoard;
+
+        stressThreads.emplace_back([pHelper,
+                                    threadIdx,
+                                    numWalks,
+                                    isWhite,
+                                    &stressTable,
+                                    &numHits,
+                                    &numBadHits]()
+            {
+                uint64 randState = 0x9E3779B97F4A7C15ull * (threadIdx + 1);
+                uint64 hits      = 0ull;
+                uint64 badHits   = 0ull;
+                for (uint32 walk = 0; walk < numWalks; walk++)
+                {
+                    if (isWhite)
+                    {
+                        pHelper->TTStressTestWalk<true>(
+                            &stressTable, 0, StressWalkDepth, &randState, &hits, &badHits);
+                    }
+                    else
+                    {
+                        pHelper->TTStressTestWalk<false>(
+                            &stressTable, 0, StressWalkDepth, &randState, &hits, &badHits);
+                    }
+                }
+                numHits[threadIdx]    = hits;
+                numBadHits[threadIdx] = badHits;
+            });
+    }
+
+    for (std::thread& stressThread : stressThreads)
+    {
+        stressThread.join();
+    }
+
+    auto endTime   = std::chrono::steady_clock::now();
+    auto totalTime = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+
+    uint64 totalHits    = 0ull;
+    uint64 totalBadHits = 0ull;
+    for (uint32 threadIdx = 0; threadIdx < numThreads; threadIdx++)
+    {
+        totalHits    += numHits[threadIdx];
+        totalBadHits += numBadHits[threadIdx];
+    }
+
+    stressTable.Destroy();
+
+    std::cout << "Threads       : " << numThreads                         << std::endl;
+    std::cout << "Walks         : " << numWalks * numThreads              << std::endl;
+    std::cout << "Probes        : " << numWalks * numThreads * (StressWalkDepth + 1) << std::endl;
+    std::cout << "Key matches   : " << totalHits                          << std::endl;
+    std::cout << "Bad entries   : " << totalBadHits                       << std::endl;
+    std::cout << "Time          : " << totalTime.count() << " ms"         << std::endl;
+    std::cout << ((totalBadHits == 0) ? "PASSED" : "FAILED")              << std::endl;
+
+    return (totalBadHits == 0);
+}
+
+void ChessEngine::DoTTBenchmark()
+{
+    constexpr uint32 NumProbes    = 1 << 24;
+    constexpr uint32 CachedSizeMB = 1;
+
+    m_transTable.BenchmarkProbes(NumProbes);
+
+    TranspositionTable cachedTable;
+    cachedTable.Init(CachedSizeMB);
+    cachedTable.BenchmarkProbes(NumProbes);
+    cachedTable.Destroy();
+}
+
+void ChessEngine::DoMakeMoveBenchmark()
+{
+    constexpr uint32 NumMakeUnmakes = 1 << 24;
+    constexpr uint32 NumRuns        = 3;
+
+    const bool isWhite = m_pBoard->GetBoardStateIsWhiteTurn();
+
+    Move** ppMoveList = m_pppMoveLists[0];
+    m_pBoard->InvalidateCheckPinAndIllegalMoves();
+    if (isWhite)
+    {
+        m_pBoard->GenerateLegalMoves<true, false>(ppMoveList);
+    }
+    else
+    {
+        m_pBoard->GenerateLegalMoves<false, false>(ppMoveList);
+    }
+
+    Move   legalMoves[MaxMovesPerPosition];
+    uint32 numMoves = 0;
+
+    GetNextMoveData nextMoveData = InitGetNextMoveData();
+    const SearchSettings settings = {};
+    Move curMove = (isWhite) ? GetNextMove<true>(ppMoveList, &nextMoveData, settings) :
+                               GetNextMove<false>(ppMoveList, &nextMoveData, settings);
+    while ((curMove.fromPiece != Piece::EndOfMoveList) && (numMoves < MaxMovesPerPosition))
+    {
+        legalMoves[numMoves++] = curMove;
+        curMove = (isWhite) ? GetNextMove<true>(ppMoveList, &nextMoveData, settings) :
+                              GetNextMove<false>(ppMoveList, &nextMoveData, settings);
+    }
+
+    if (numMoves == 0)
+    {
+        std::cout << "No legal moves" << std::endl;
+        return;
+    }
+
+    const uint32 numPasses = std::max<uint32>(NumMakeUnmakes / numMoves, 1);
+
+    uint64 sink     = 0ull;
+    uint64 bestTime = UINT64_MAX;
+    for (uint32 run = 0; run < NumRuns; run++)
+    {
+        const uint64 runTime = (isWhite) ? TimeMakeUnmake<true>(legalMoves, numMoves, numPasses, &sink) :
+                                           TimeMakeUnmake<false>(legalMoves, numMoves, numPasses, &sink);
+        bestTime = std::min(bestTime, runTime);
+    }
+
+    const float makeUnmakeNs = static_cast<float>(bestTime) / (static_cast<uint64>(numPasses) * numMoves);
+
+    std::cout << "BoardInfo      : " << sizeof(BoardInfo) << " bytes" << std::endl;
+    std::cout << "Undo entry     : " << sizeof(UndoEntry) << " bytes" << std::endl;
+    std::cout << "Moves          : " << numMoves                      << std::endl;
+    std::cout << "Make + unmake  : " << makeUnmakeNs << " ns/move"    << std::endl;
+    std::cout << "Key sum        : " << std::hex << sink << std::dec  << std::endl;
+}
+
+// Makes and unmakes every move numPasses times, returns the time in ns.  The keys of the made
+// positions are summed into pSink so none of the work can be skipped.
+template<bool isWhite>
+uint64 ChessEngine::TimeMakeUnmake(const Move* pMoves, uint32 numMoves, uint32 numPasses, uint64* pSink)
+{
+    uint64 sink = 0ull;
+
+    auto startTime = std::chrono::steady_clock::now();
+    for (uint32 pass = 0; pass < numPasses; pass++)
+    {
+        for (uint32 moveIdx = 0; moveIdx < numMoves; moveIdx++)
+        {
+            m_pBoard->MakeMove<isWhite>(pMoves[moveIdx]);
+            sink += m_pBoard->GetZobKey();
+            m_pBoard->UnmakeMove<isWhite>();
+        }
+    }
+    auto endTime = std::chrono::steady_clock::now();
+
+    *pSink ^= sink;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+// Probes the table, checks that anything found is a legal move with the right score, then stores
+// a random legal move and plays it.
+template<bool isWhite>
+void ChessEngine::TTStressTestWalk(
+    TranspositionTable* pTable,
+    uint32              ply,
+    uint32              maxPly,
+    uint64*             pRandState,
+    uint64*             pNumHits,
+    uint64*             pNumBadHits)
+{
+    Move** ppMoveList = m_pppMoveLists[ply];
+
+    m_pBoard->InvalidateCheckPinAndIllegalMoves();
+    m_pBoard->GenerateLegalMoves<isWhite, false>(ppMoveList);
+
+    Move   legalMoves[MaxMovesPerPosition];
+    uint32 numMoves = 0;
+
+    GetNextMoveData nextMoveData = InitGetNextMoveData();
+    const SearchSettings settings = {};
+    Move            curMove      = GetNextMove<isWhite>(ppMoveList, &nextMoveData, settings);
+    while ((curMove.fromPiece != Piece::EndOfMoveList) && (numMoves < MaxMovesPerPosition))
+    {
+        legalMoves[numMoves++] = curMove;
+        curMove = GetNextMove<isWhite>(ppMoveList, &nextMoveData, settings);
+    }
+
+    if (numMoves == 0)
+    {
+        return;
+    }
+
+    const uint64 zobKey = m_pBoard->GetZobKey();
+
+    // Everything is inserted deeper than this, so every key match comes back with its score.
+    constexpr int32 StressProbeDepth = TTQSearchDepth + 1;
+
+    Move ttMove = pTable->ProbeTable(zobKey, StressProbeDepth, InitialAlpha, InitialBeta);
+    if (ttMove.score != TTScoreNotFound)
+    {
+        (*pNumHits)++;
+
+        bool isLegal = false;
+        for (uint32 moveIdx = 0; moveIdx < numMoves; moveIdx++)
+        {
+            const Move& legalMove = legalMoves[moveIdx];
+            const bool  sameMove  = (ttMove.fromPiece == legalMove.fromPiece) &&
+                                    (ttMove.flags     == legalMove.flags)     &&
+                                    (ttMove.fromIdx   == legalMove.fromIdx)   &&
+                                    (ttMove.toIdx     == legalMove.toIdx)     &&
+                                    (ttMove.toPiece   == legalMove.toPiece);
+            if (sameMove)
+            {
+                isLegal = true;
+                break;
+            }
+        }
+
+        if ((isLegal == false) || (ttMove.score != GetTTStressTestScore(zobKey)))
+        {
+            (*pNumBadHits)++;
+        }
+    }
+
+    // xorshift64
+    *pRandState ^= *pRandState << 13;
+    *pRandState ^= *pRandState >> 7;
+    *pRandState ^= *pRandState << 17;
+
+    Move insertMove  = legalMoves[*pRandState % numMoves];
+    insertMove.score = GetTTStressTestScore(zobKey);
+
+    // Random depths so entries get replaced in both directions.
+    const int32 insertDepth = StressProbeDepth +
+        static_cast<int32>((*pRandState >> 32) % (MaxEngineDepth - StressProbeDepth));
+    pTable->InsertToTable(zobKey, insertDepth, insertMove, TTScoreType::Exact);
+
+    if (ply < maxPly)
+    {
+        m_pBoard->MakeMove<isWhite>(insertMove);
+        TTStressTestWalk<!isWhite>(pTable, ply + 1, maxPly, pRandState, pNumHits, pNumBadHits);
+        m_pBoard->UnmakeMove<isWhite>();
+    }
+}
+
+void ChessEngine::DoPerft(
+    uint32 depth,
+    bool   isWhite,
+    bool   expanded,
+    uint32 numThreads,
+    bool   reportSpeedup,
+    bool   useHash)
+{
+    numThreads = std::min(std::max<uint32>(numThreads, 1), MaxSearchThreads);
+
+    UsePerftTable(useHash);
+
+    // Expanded prints a count for every root move as it goes, so it stays single threaded.  Depth 1
+    // is just the root move generation.
+    const bool isParallel = (numThreads > 1) && (expanded == false) && (depth > 1);
+
+    uint64 serialPositions = 0ull;
+    TimeType serialTime    = TimeType(0);
+
+    if ((isParallel == false) || reportSpeedup)
+    {
+        m_searchValues.positionsSearched = 0ull;
+        m_searchValues.perftTableHits    = 0ull;
+        if (useHash)
+        {
+            m_perftTable.ResetTable();
+        }
+
+        auto startTime = std::chrono::steady_clock::now();
+
+        if (isWhite)
+        {
+            RunPerft<true>(depth, expanded);
+        }
+        else
+        {
+            RunPerft<false>(depth, expanded);
+        }
+
+        auto endTime    = std::chrono::steady_clock::now();
+        serialTime      = std::chrono::duration_cast<TimeType>(endTime - startTime);
+        serialPositions = m_searchValues.positionsSearched;
+
+        uint32 knps = 0;
+        if (serialTime.count() > 0)
+        {
+            knps = serialPositions / serialTime.count();
+        }
+
+        std::cout << "Time              : " << serialTime.count() << " ms" << std::endl;
+        std::cout << "Positions searched: " << serialPositions << std::endl;
+        std::cout << "Knps              : " << knps << std::endl;
+        if (useHash)
+        {
+            std::cout << "Perft table hits  : " << m_searchValues.perftTableHits << std::endl;
+        }
+    }
+
+    if (isParallel == false)
+    {
+        return;
+    }
+
+    if (useHash)
+    {
+        m_perftTable.ResetTable();
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    if (isWhite)
+    {
+        ParallelPerft<true>(depth, numThreads, true);
+    }
+    else
+    {
+        ParallelPerft<false>(depth, numThreads, true);
+    }
+    auto endTime = std::chrono::steady_clock::now();
+    TimeType parallelTime = std::max(std::chrono::duration_cast<TimeType>(endTime - startTime),
+                                     TimeType(1));
+
+    if (reportSpeedup)
+    {
+        const uint64 parallelPositions = GetPositionsSearched();
+        const float  speedup = static_cast<float>(std::max<int64>(serialTime.count(), 1)) /
+                               parallelTime.count();
+
+        std::cout << "Speedup           : " << speedup << "x" << std::endl;
+        std::cout << "Efficiency        : " << 100.0f * speedup / numThreads << "%" << std::endl;
+        std::cout << ((parallelPositions == serialPositions) ? "Node counts match" :
+                                                               "NODE COUNT MISMATCH") << std::endl;
+    }
+}
+
+// Same count as DoPerft for the side to move, without printing anything.  The perft table isn't
+// cleared, entries are keyed by position so they stay good from one call to the next, and
+// clearing a big table costs more than counting most suite positions.
+uint64 ChessEngine::CountPerft(uint32 depth, uint32 numThreads, bool useHash)
+{
+    numThreads = std::min(std::max<uint32>(numThreads, 1), MaxSearchThreads);
+
+    UsePerftTable(useHash);
+
+    const bool isWhite = m_pBoard->GetBoardStateIsWhiteTurn();
+    uint64     count   = 0ull;
+
+    if ((numThreads > 1) && (depth > 1))
     {
         if (isWhite)
         {
-            PerftExpanded<true>(depth);
+            ParallelPerft<true>(depth, numThreads, false);
         }
         else
         {
-            PerftExpanded<false>(depth);
+            ParallelPerft<false>(depth, numThreads, false);
         }
+        count = GetPositionsSearched();
     }
     else
     {
+        m_searchValues.positionsSearched = 0ull;
         if (isWhite)
         {
             Perft<true>(depth, 0);
@@ -238,30 +769,254 @@ void ChessEngine::DoPerft(uint32 depth, bool isWhite, bool expanded)
         {
             Perft<false>(depth, 0);
         }
+        count = m_searchValues.positionsSearched;
     }
-    
-    auto endTime = std::chrono::steady_clock::now();
-    auto totalTime = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
 
-    uint32 knps = 0;
-    if (totalTime.count() > 0)
+    return count;
+}
+
+void ChessEngine::UsePerftTable(bool useHash)
+{
+    m_pPerftTable = nullptr;
+    if (useHash)
+    {
+        if (m_perftTable.IsInitialized() == false)
+        {
+            m_perftTable.Init(DefaultPerftTableSizeMB);
+        }
+        m_pPerftTable = &m_perftTable;
+    }
+}
+
+template<bool isWhite>
+void ChessEngine::RunPerft(uint32 depth, bool expanded)
+{
+    if (expanded)
+    {
+        PerftExpanded<isWhite>(depth);
+    }
+    else
+    {
+        Perft<isWhite>(depth, 0);
+    }
+}
+
+// Splits the tree into tasks and hands them out to numThreads helpers through a shared index.  The
+// tasks are ordered the way the serial perft walks them, and big and small subtrees are spread all
+// through the list, so taking the next one off the top balances well enough without any stealing.
+// Every helper counts into its own m_searchValues, so the only shared write is the task index.
+template<bool isWhite>
+void ChessEngine::ParallelPerft(uint32 depth, uint32 numThreads, bool printStats)
+{
+    m_searchValues.positionsSearched = 0ull;
+    m_searchValues.perftTableHits    = 0ull;
+
+    // Split one ply deeper until there are enough tasks to go around, always leaving at least one
+    // ply for the workers so they count the leaves the same way the serial perft does.
+    const uint32 maxSplitPly = std::min(MaxPerftSplitPly, depth - 1);
+    std::vector<PerftTask> tasks;
+    for (uint32 splitPly = 1; splitPly <= maxSplitPly; splitPly++)
+    {
+        tasks.clear();
+        PerftTask task = {};
+        SplitPerftTasks<isWhite>(splitPly, 0, &task, &tasks);
+        if (tasks.size() >= numThreads * PerftTasksPerThread)
+        {
+            break;
+        }
+    }
+
+    CreateHelperEngines(numThreads);
+
+    // Earlier runs may have used more helpers, and GetPositionsSearched counts all of them.
+    for (ChessEngine* pHelper : m_helperEngines)
+    {
+        pHelper->m_searchValues = {};
+        pHelper->m_pPerftTable  = m_pPerftTable;
+    }
+
+    std::atomic<uint32>      nextTask = 0;
+    std::vector<uint32>      numTasksDone(numThreads, 0);
+    std::vector<TimeType>    busyTimes(numThreads, TimeType(0));
+    std::vector<std::thread> perftThreads;
+    const Board&             rootBoard = *m_pBoard;
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (uint32 threadIdx = 0; threadIdx < numThreads; threadIdx++)
+    {
+        ChessEngine* pHelper = m_helperEngines[threadIdx];
+
+        perftThreads.emplace_back([pHelper,
+                                   threadIdx,
+                                   depth,
+                                   &rootBoard,
+                                   &tasks,
+                                   &nextTask,
+                                   &numTasksDone,
+                                   &busyTimes]()
+            {
+                auto threadStart = std::chrono::steady_clock::now();
+                uint32 taskIdx = nextTask.fetch_add(1, std::memory_order_relaxed);
+                while (taskIdx < tasks.size())
+                {
+                    pHelper->RunPerftTask(rootBoard, isWhite, depth, tasks[taskIdx]);
+                    numTasksDone[threadIdx]++;
+                    taskIdx = nextTask.fetch_add(1, std::memory_order_relaxed);
+                }
+                auto threadEnd = std::chrono::steady_clock::now();
+                busyTimes[threadIdx] = std::chrono::duration_cast<TimeType>(threadEnd - threadStart);
+            });
+    }
+
+    for (std::thread& perftThread : perftThreads)
+    {
+        perftThread.join();
+    }
+
+    auto endTime  = std::chrono::steady_clock::now();
+    auto wallTime = std::max(std::chrono::duration_cast<TimeType>(endTime - startTime), TimeType(1));
+
+    if (printStats == false)
     {
-        knps = m_searchValues.positionsSearched / totalTime.count();
+        return;
     }
 
-    std::cout << "Time              : " << totalTime.count() << " ms" << std::endl;
-    std::cout << "Positions searched: " << m_searchValues.positionsSearched << std::endl;
-    std::cout << "Knps              : " << knps << std::endl;
+    const uint64 totalPositions = GetPositionsSearched();
+    uint64       totalBusyMs    = 0ull;
+    uint64       totalHits      = 0ull;
+
+    std::cout << "Threads           : " << numThreads << std::endl;
+    std::cout << "Tasks             : " << tasks.size() << std::endl;
+    for (uint32 threadIdx = 0; threadIdx < numThreads; threadIdx++)
+    {
+        const uint64   positions = m_helperEngines[threadIdx]->m_searchValues.positionsSearched;
+        const TimeType busyTime  = std::max(busyTimes[threadIdx], TimeType(1));
+        totalBusyMs += busyTimes[threadIdx].count();
+        totalHits   += m_helperEngines[threadIdx]->m_searchValues.perftTableHits;
+
+        std::cout << "  Thread " << threadIdx
+                  << " -- tasks: "     << numTasksDone[threadIdx]
+                  << " -- positions: " << positions
+                  << " -- time: "      << busyTimes[threadIdx].count() << " ms"
+                  << " -- Knps: "      << positions / busyTime.count() << std::endl;
+    }
+
+    // How much of the wall time the threads spent counting, 100% means none of them sat idle
+    // waiting for the last task to finish.
+    const float utilization = 100.0f * totalBusyMs / (static_cast<float>(wallTime.count()) * numThreads);
+
+    std::cout << "Time              : " << wallTime.count() << " ms" << std::endl;
+    std::cout << "Positions searched: " << totalPositions << std::endl;
+    std::cout << "Knps              : " << totalPositions / wallTime.count() << std::endl;
+    std::cout << "Thread utilization: " << utilization << "%" << std::endl;
+    if (m_pPerftTable != nullptr)
+    {
+        std::cout << "Perft table hits  : " << totalHits << std::endl;
+    }
+}
+
+// Collects every line of splitPly moves from the current position.  Lines that end early in mate
+// or stalemate have no leaves at the full depth, so they're left out.
+template<bool isWhite>
+void ChessEngine::SplitPerftTasks(
+    uint32                  splitPly,
+    uint32                  ply,
+    PerftTask*              pTask,
+    std::vector<PerftTask>* pTasks)
+{
+    if (ply == splitPly)
+    {
+        pTask->numMoves = splitPly;
+        pTasks->push_back(*pTask);
+        return;
+    }
+
+    Move** ppMoveList = m_pppMoveLists[ply];
+    m_pBoard->InvalidateCheckPinAndIllegalMoves();
+    m_pBoard->GenerateLegalMoves<isWhite, false>(ppMoveList);
+
+    GetNextMoveData nextMoveData = InitGetNextMoveData();
+    const SearchSettings settings = {};
+    Move            curMove      = GetNextMove<isWhite>(ppMoveList, &nextMoveData, settings);
+
+    while (curMove.fromPiece != Piece::EndOfMoveList)
+    {
+        pTask->moves[ply] = curMove;
+
+        m_pBoard->MakeMove<isWhite>(curMove);
+        SplitPerftTasks<!isWhite>(splitPly, ply + 1, pTask, pTasks);
+        m_pBoard->UnmakeMove<isWhite>();
+
+        curMove = GetNextMove<isWhite>(ppMoveList, &nextMoveData, settings);
+    }
+}
+
+// Only called on helpers.  Plays the task's moves on a fresh copy of the root and counts the rest
+// of the subtree into this helper's positionsSearched.
+void ChessEngine::RunPerftTask(const Board& rootBoard, bool isWhite, uint32 depth, const PerftTask& task)
+{
+    m_helperBoard = rootBoard;
+
+    bool isWhiteTurn = isWhite;
+    for (uint32 moveIdx = 0; moveIdx < task.numMoves; moveIdx++)
+    {
+        if (isWhiteTurn)
+        {
+            m_pBoard->MakeMove<true>(task.moves[moveIdx]);
+        }
+        else
+        {
+            m_pBoard->MakeMove<false>(task.moves[moveIdx]);
+        }
+        isWhiteTurn = !isWhiteTurn;
+    }
+
+    if (isWhiteTurn)
+    {
+        Perft<true>(depth - task.numMoves, task.numMoves);
+    }
+    else
+    {
+        Perft<false>(depth - task.numMoves, task.numMoves);
+    }
 }
 
 template<bool isWhite>
 uint32 ChessEngine::Perft(uint32 depth, uint32 ply)
 {
+    // The side to move, castling rights and en passant square are all in the key, so two
+    // positions with the same key and depth have the same count.
+    const bool   useHash = (m_pPerftTable != nullptr) && (depth >= PerftTableMinDepth);
+    const uint64 zobKey  = m_pBoard->GetZobKey();
+    if (useHash)
+    {
+        uint64 count = 0ull;
+        if (m_pPerftTable->ProbeTable(zobKey, depth, &count))
+        {
+            m_searchValues.positionsSearched += count;
+            m_searchValues.perftTableHits++;
+            return 0;
+        }
+    }
+    const uint64 startPositions = m_searchValues.positionsSearched;
+
     Move** ppMoveList = m_pppMoveLists[ply];
 
     uint32 numMoves = 0;
 
     m_pBoard->InvalidateCheckPinAndIllegalMoves();
+
+    // The last layer only needs to know how many moves there are, not what they are.
+    if constexpr (PerftBulkCount)
+    {
+        if (depth <= 1)
+        {
+            m_searchValues.positionsSearched += m_pBoard->CountLegalMoves<isWhite>();
+            return 0;
+        }
+    }
+
     m_pBoard->GenerateLegalMoves<isWhite, false>(ppMoveList, &numMoves);
 
     // We've generated the moves all the moves for the last layer already, no reason to actually count them.
@@ -276,20 +1031,20 @@ uint32 ChessEngine::Perft(uint32 depth, uint32 ply)
     const SearchSettings settings = {};
     Move            curMove      = GetNextMove<isWhite>(ppMoveList, &nextMoveData, settings);
 
-    BoardInfo prevBoardData = {};
-    uint64 prevBoardPieces[static_cast<uint32>(Piece::PieceCount)];
-    m_pBoard->CopyBoardData(&prevBoardData);
-    m_pBoard->CopyPieceData(&(prevBoardPieces[0]));
-
     while (curMove.fromPiece != Piece::EndOfMoveList)
     {
         m_pBoard->MakeMove<isWhite>(curMove);
         Perft<!isWhite>(depth-1, ply+1);
-        m_pBoard->UndoMove(&prevBoardData, &(prevBoardPieces[0]));
+        m_pBoard->UnmakeMove<isWhite>();
 
         curMove = GetNextMove<isWhite>(ppMoveList, &nextMoveData, settings);
     }
 
+    if (useHash)
+    {
+        m_pPerftTable->InsertToTable(zobKey, depth, m_searchValues.positionsSearched - startPositions);
+    }
+
     return 0;
 }
 
@@ -300,11 +1055,6 @@ void ChessEngine::PerftExpanded(uint32 depth)
     m_pBoard->InvalidateCheckPinAndIllegalMoves();
     m_pBoard->GenerateLegalMoves<isWhite, false>(ppMoveList);
 
-    BoardInfo prevBoardData = {};
-    uint64 prevBoardPieces[static_cast<uint32>(Piece::PieceCount)];
-    m_pBoard->CopyBoardData(&prevBoardData);
-    m_pBoard->CopyPieceData(&(prevBoardPieces[0]));
-
     uint32 prevNumMoves = 0;
     std::string prevMoveStr = "00";
 
@@ -323,7 +1073,7 @@ void ChessEngine::PerftExpanded(uint32 depth)
         {
             m_searchValues.positionsSearched++;
         }
-        m_pBoard->UndoMove(&prevBoardData, &(prevBoardPieces[0]));
+        m_pBoard->UnmakeMove<isWhite>();
 
         std::string moveStr = m_pBoard->GetStringFromMove(curMove);
 
@@ -368,9 +1118,10 @@ Move ChessEngine::IterativeDeepening(
     TimeType maxTime = (searchTime * 7) / 10;
 
     auto startTime = std::chrono::steady_clock::now();
-    uint32 searchDepth = 1;
+    uint32 searchDepth = 1 + (m_threadIdx % 2);
 
-    bool continueSearch = true;
+    bool continueSearch    = true;
+    bool finishedIteration = false;
 
     Move curMove = {};
     while (continueSearch)
@@ -400,22 +1151,27 @@ Move ChessEngine::IterativeDeepening(
                                           isTimedOut);
         }
 
+        auto curTime = std::chrono::steady_clock::now();
+        TimeType elapsedTime = std::chrono::duration_cast<TimeType>(curTime - startTime);
+
         if (isTimedOut.load(std::memory_order_relaxed) == false)
         {
-            bestMove = curMove;
+            bestMove          = curMove;
+            finishedIteration = true;
+            if (m_printUciInfo)
+            {
+                PrintUciInfo<isWhite>(searchDepth, bestMove, elapsedTime);
+            }
         }
 
         searchDepth++;
-        auto curTime = std::chrono::steady_clock::now();
 
         bool isCheckMate = (bestMove.score < NegCheckMateScore + 2*MaxEngineDepth) ||
                            (bestMove.score > PosCheckMateScore - 2*MaxEngineDepth);
 
         bool isStaleMate = (bestMove.score == 0)      &&
-                           (bestMove.fromPos == 0ull) &&
-                           (bestMove.toPos == 0ull);
+                           bestMove.IsNull();
 
-        TimeType elapsedTime = std::chrono::duration_cast<TimeType>(curTime - startTime);
         continueSearch = (((searchDepth < depth)   && (useTime == false)) ||
                           ((elapsedTime < maxTime) && (useTime == true))) &&
                          (isTimedOut.load(std::memory_order_relaxed) == false) &&
@@ -423,6 +1179,12 @@ Move ChessEngine::IterativeDeepening(
                          (isStaleMate == false);
     }
 
+    // Being stopped or hitting the node limit still has to give a move to play.
+    if (finishedIteration == false)
+    {
+        bestMove = GetFallbackMove<isWhite>(curMove);
+    }
+
     if (pMaxDepth != nullptr)
     {
         *pMaxDepth = searchDepth - 1;
@@ -430,6 +1192,75 @@ Move ChessEngine::IterativeDeepening(
     return bestMove;
 }
 
+template<bool isWhite>
+Move ChessEngine::GetFallbackMove(const Move& partialBestMove)
+{
+    m_pBoard->InvalidateCheckPinAndIllegalMoves();
+    if ((partialBestMove.IsNull() == false) &&
+        m_pBoard->IsMoveLegal<isWhite>(partialBestMove))
+    {
+        return partialBestMove;
+    }
+
+    Move** ppMoveList = m_pppMoveLists[0];
+    m_pBoard->GenerateLegalMoves<isWhite, false>(ppMoveList);
+
+    GetNextMoveData nextMoveData = InitGetNextMoveData();
+    const SearchSettings settings = {};
+    Move            firstMove    = GetNextMove<isWhite>(ppMoveList, &nextMoveData, settings);
+    if (firstMove.fromPiece == Piece::EndOfMoveList)
+    {
+        return {};
+    }
+
+    firstMove.score = 0;
+    return firstMove;
+}
+
+// The score is for the side to move, and so is the zobrist key, so a cached score is always
+// the right way round.  A lazy score is only a bound, so it isn't cached.
+template<bool isWhite>
+int32 ChessEngine::EvaluateBoard(int32 alpha, int32 beta, const SearchSettings& settings)
+{
+    const uint64 zobKey = m_pBoard->GetZobKey();
+
+    int32 score = 0;
+    if (m_pEvalCache->ProbeCache(zobKey, &score))
+    {
+        m_searchValues.evalCacheHits++;
+        return score;
+    }
+
+    m_searchValues.evalCacheMisses++;
+
+    // The network has no cheap part to stop after, so it's always the full eval.
+    if (m_pBoard->UsesNnue())
+    {
+        score = m_pBoard->EvaluateNnue<isWhite>();
+        m_pEvalCache->InsertToCache(zobKey, score);
+        return score;
+    }
+
+    if (settings.lazyEval == false)
+    {
+        score = m_pBoard->ScoreBoard<isWhite>();
+        m_pEvalCache->InsertToCache(zobKey, score);
+        return score;
+    }
+
+    bool lazyExit = false;
+    score = m_pBoard->ScoreBoard<isWhite>(alpha, beta, settings.lazyEvalMargin, &lazyExit);
+    if (lazyExit)
+    {
+        m_searchValues.lazyEvalExits++;
+    }
+    else
+    {
+        m_pEvalCache->InsertToCache(zobKey, score);
+    }
+    return score;
+}
+
 template<bool isWhite, bool onPlyZero>
 int32 ChessEngine::Negmax(
     int32              depth,
@@ -448,6 +1279,12 @@ int32 ChessEngine::Negmax(
     m_pBoard->InvalidateCheckPinAndIllegalMoves();
     m_searchValues.positionsSearched++;
 
+    // The node limit works the same as running out of time, so this iteration gets thrown away.
+    if (m_searchValues.positionsSearched >= m_maxNodes)
+    {
+        isTimedOut.store(true);
+    }
+
     // We flip the team here because in reality we're checking whether or not the previous move
     // caused a draw by repetition.
     bool isDraw = m_pBoard->IsDrawByRepetition<!isWhite>();
@@ -457,8 +1294,8 @@ int32 ChessEngine::Negmax(
         if constexpr (onPlyZero)
         {
             *pBestMove = {};
-            pBestMove->fromPos = 0ull;
-            pBestMove->toPos   = 0ull;
+            pBestMove->fromIdx = 0;
+            pBestMove->toIdx   = 0;
 
             pBestMove->score   = 0;
         }
@@ -481,7 +1318,7 @@ int32 ChessEngine::Negmax(
     // Prefetch the TT before generating the check and pin masks.  Prefetching the TT data make
     // the engine ~10% faster.
     uint64 zobKey = m_pBoard->GetZobKey();
-    m_pMainSearchTransTable->PrefetchEntry(zobKey);
+    m_pTransTable->PrefetchEntry(zobKey);
 
     settings.expectedCutNode = !settings.expectedCutNode;
     if (settings.onPv)
@@ -497,7 +1334,7 @@ int32 ChessEngine::Negmax(
     TTScoreType ttScoreType = TTScoreType::LowerBound;
     bool ttMoveValid = false;
     Move ttMove = {};
-    ttMove = m_pMainSearchTransTable->ProbeTable(zobKey, depth, alpha, beta);
+    ttMove = m_pTransTable->ProbeTable(zobKey, depth, alpha, beta);
 
     ttMoveValid = ttMove.score != TTScoreNotFound;
     if (ttMoveValid)
@@ -526,8 +1363,9 @@ int32 ChessEngine::Negmax(
                                   (inCheck == false);
     if (canFutilityPrune)
     {
-        int32 futilityScore = m_pBoard->ScoreBoard<isWhite>();
-        if (futilityScore < alpha - settings.futilityCutoff)
+        const int32 futilityAlpha = alpha - settings.futilityCutoff;
+        int32 futilityScore = EvaluateBoard<isWhite>(futilityAlpha, futilityAlpha + 1, settings);
+        if (futilityScore < futilityAlpha)
         {
             int32 maxFreePly = ply + settings.quiescenceDepthLimit;
             int32 score = QuiscenceSearch<isWhite>(ply, alpha, beta, settings, isTimedOut, maxFreePly);
@@ -542,8 +1380,9 @@ int32 ChessEngine::Negmax(
                                           (inCheck == false);
     if (canExtendedFutilityPrune)
     {
-        int32 futilityScore = m_pBoard->ScoreBoard<isWhite>();
-        if (futilityScore < alpha - settings.extendedFutilityCutoff)
+        const int32 futilityAlpha = alpha - settings.extendedFutilityCutoff;
+        int32 futilityScore = EvaluateBoard<isWhite>(futilityAlpha, futilityAlpha + 1, settings);
+        if (futilityScore < futilityAlpha)
         {
             int32 maxFreePly = ply + settings.quiescenceDepthLimit;
             int32 score = QuiscenceSearch<isWhite>(ply, alpha, beta, settings, isTimedOut, maxFreePly);
@@ -552,11 +1391,6 @@ int32 ChessEngine::Negmax(
         }
     }
 
-    BoardInfo prevBoardData = {};
-    uint64 prevBoardPieces[static_cast<uint32>(Piece::PieceCount)];
-    m_pBoard->CopyBoardData(&prevBoardData);
-    m_pBoard->CopyPieceData(&(prevBoardPieces[0]));
-
     // If we can do a NullMoveReduction
     const bool canDoNullMoveReduction = (settings.doNullMoveReduction)  &&
                                         (settings.onPv == false)        &&
@@ -582,7 +1416,7 @@ int32 ChessEngine::Negmax(
                                                 settings,
                                                 isTimedOut);
         nullMoveScore *= -1;
-        m_pBoard->UndoMove(&prevBoardData, &(prevBoardPieces[0]));
+        m_pBoard->UnmakeNullMove();
 
         settings.quiescenceDepthLimit = origQSearchLimit;
         settings.doNullMoveReduction = true;
@@ -620,7 +1454,7 @@ int32 ChessEngine::Negmax(
                                                 settings,
                                                 isTimedOut);
         nullMoveScore *= -1;
-        m_pBoard->UndoMove(&prevBoardData, &(prevBoardPieces[0]));
+        m_pBoard->UnmakeNullMove();
 
         if (nullMoveScore >= beta)
         {
@@ -669,7 +1503,7 @@ int32 ChessEngine::Negmax(
                                                               settings,
                                                               isTimedOut);
             multiCutMoveScore *= -1;
-            m_pBoard->UndoMove(&prevBoardData, &(prevBoardPieces[0]));
+            m_pBoard->UnmakeMove<isWhite>();
 
             if (multiCutMoveScore >= beta)
             {
@@ -762,7 +1596,7 @@ int32 ChessEngine::Negmax(
                 m_searchValues.nullWindowReSearches++;
             }
         }
-        m_pBoard->UndoMove(&prevBoardData, &(prevBoardPieces[0]));
+        m_pBoard->UnmakeMove<isWhite>();
 
         if (bestScore < moveScore)
         {
@@ -810,8 +1644,8 @@ int32 ChessEngine::Negmax(
     if ((numMoves == 0) && (inCheck == false))
     {
         // Set the from pos to be 0ull to make sure we know it is a stalemate in the engine.
-        bestMove.fromPos = 0ull;
-        bestMove.toPos   = 0ull;
+        bestMove.fromIdx = 0;
+        bestMove.toIdx   = 0;
         bestMove.score   = 0;
         bestScore        = 0;
         m_searchValues.drawsDetected++;
@@ -826,7 +1660,12 @@ int32 ChessEngine::Negmax(
         *pBestMove = bestMove;
     }
 
-    m_pMainSearchTransTable->InsertToTable(m_pBoard->GetZobKey(), depth, bestMove, ttScoreType);
+    // A search that got stopped part way through has a made up score.  This matters most for the
+    // Lazy SMP helpers, which are always stopped in the middle of a deep search.
+    if (isTimedOut.load(std::memory_order_relaxed) == false)
+    {
+        m_pTransTable->InsertToTable(m_pBoard->GetZobKey(), depth, bestMove, ttScoreType);
+    }
 
     return bestScore;
 }
@@ -850,14 +1689,17 @@ int32 ChessEngine::QuiscenceSearch(
     m_searchValues.positionsSearched++;
     m_searchValues.quiscenceSearched++;
 
-    int32 standPatScore = m_pBoard->ScoreBoard<isWhite>();
+    // Stand pat only has to be exact if it's returned as it is, or if it's somewhere between the
+    // futility cutoff below and beta.
+    const bool  returnStandPat  = (ply >= MaxEngineDepth) ||
+                                  ((ply >= maxFreePly) && (movedPieces == 0ull));
+    const int32 standPatAlpha   = (returnStandPat) ? InitialAlpha :
+                                  alpha - (PieceScores::QueenScore + PieceScores::RookScore);
+    const int32 standPatBeta    = (returnStandPat) ? InitialBeta : beta;
 
-    if (ply >= MaxEngineDepth)
-    {
-        return standPatScore;
-    }
+    int32 standPatScore = EvaluateBoard<isWhite>(standPatAlpha, standPatBeta, settings);
 
-    if ((ply >= maxFreePly) && (movedPieces == 0ull))
+    if (returnStandPat)
     {
         return standPatScore;
     }
@@ -874,11 +1716,11 @@ int32 ChessEngine::QuiscenceSearch(
         return alpha;
     }
 
-    m_pQSearchTransTable->PrefetchEntry(m_pBoard->GetZobKey());
+    m_pTransTable->PrefetchEntry(m_pBoard->GetZobKey());
     m_pBoard->GenerateCheckAndPinMask<isWhite>();
 
     TTScoreType ttScoreType = TTScoreType::LowerBound;
-    Move ttMove = m_pQSearchTransTable->ProbeTable(m_pBoard->GetZobKey(), 0, alpha, beta);
+    Move ttMove = m_pTransTable->ProbeTable(m_pBoard->GetZobKey(), TTQSearchDepth, alpha, beta);
 
     bool ttMoveValid = ttMove.score != TTScoreNotFound;
     if (ttMoveValid)
@@ -909,11 +1751,6 @@ int32 ChessEngine::QuiscenceSearch(
         ppMoveList[MoveTypes::Best][0] = ttMove;
     }
 
-    BoardInfo prevBoardData = {};
-    uint64 prevBoardPieces[static_cast<uint32>(Piece::PieceCount)];
-    m_pBoard->CopyBoardData(&prevBoardData);
-    m_pBoard->CopyPieceData(&(prevBoardPieces[0]));
-
     int32 bestScore = standPatScore;
 
     Move  bestMove = {};
@@ -945,7 +1782,7 @@ int32 ChessEngine::QuiscenceSearch(
             continue;
         }
 
-        uint64 newMovedPieces = movedPieces | curMove.toPos;
+        uint64 newMovedPieces = movedPieces | curMove.ToPos();
 
         m_pBoard->MakeMove<isWhite>(curMove);
         didMove = true;
@@ -961,7 +1798,7 @@ int32 ChessEngine::QuiscenceSearch(
 
         bestScore = (bestScore < moveScore) ? moveScore : bestScore;
 
-        m_pBoard->UndoMove(&prevBoardData, &(prevBoardPieces[0]));
+        m_pBoard->UnmakeMove<isWhite>();
 
         if (bestScore > alpha)
         {
@@ -979,9 +1816,10 @@ int32 ChessEngine::QuiscenceSearch(
         curMove = GetNextMove<isWhite>(ppMoveList, &nextMoveData, settings);
     }
 
-    if (didMove)
+    if (didMove && (isTimedOut.load(std::memory_order_relaxed) == false))
     {
-        m_pQSearchTransTable->InsertToTable(m_pBoard->GetZobKey(), 0, bestMove, ttScoreType);
+        m_pTransTable->InsertToTable(
+            m_pBoard->GetZobKey(), TTQSearchDepth, bestMove, ttScoreType);
     }
     else if (inCheck)
     {
@@ -991,6 +1829,99 @@ int32 ChessEngine::QuiscenceSearch(
     return bestScore;
 }
 
+// One UCI info line for a finished iteration.  Scores are from the side to move's point of view,
+// which is what negmax gives back already.
+template<bool isWhite>
+void ChessEngine::PrintUciInfo(uint32 depth, const Move& bestMove, TimeType elapsedTime)
+{
+    const uint64 nodes     = GetPositionsSearched();
+    const uint64 elapsedMs = std::max<uint64>(elapsedTime.count(), 1);
+    const int32  score     = bestMove.score;
+
+    std::string scoreStr = "cp " + std::to_string(score);
+    if (score > (PosCheckMateScore - (int32)(2 * MaxEngineDepth)))
+    {
+        scoreStr = "mate " + std::to_string((PosCheckMateScore - score + 1) / 2);
+    }
+    else if (score < (NegCheckMateScore + (int32)(2 * MaxEngineDepth)))
+    {
+        scoreStr = "mate -" + std::to_string((PosCheckMateScore + score + 1) / 2);
+    }
+
+    std::string pvStr = "";
+    if (bestMove.IsNull() == false)
+    {
+        AppendPvMove<isWhite>(bestMove, depth, &pvStr);
+    }
+
+    // Built up front so it goes out as one write, the UCI thread can be printing at the same time.
+    std::string infoStr = "info depth " + std::to_string(depth) +
+                          " score "     + scoreStr +
+                          " nodes "     + std::to_string(nodes) +
+                          " nps "       + std::to_string((nodes * 1000) / elapsedMs) +
+                          " hashfull "  + std::to_string(m_pTransTable->GetHashFull()) +
+                          " time "      + std::to_string(elapsedMs) +
+                          " pv"         + pvStr + "\n";
+    std::cout << infoStr << std::flush;
+}
+
+// The PV is whatever is left in the TT.  Follows the stored moves until one is missing or
+// illegal, which can happen when an entry got replaced.
+template<bool isWhite>
+void ChessEngine::AppendPvMove(const Move& move, uint32 pvLength, std::string* pPvStr)
+{
+    *pPvStr += " " + m_pBoard->GetStringFromMove(move);
+    if (pvLength <= 1)
+    {
+        return;
+    }
+
+    m_pBoard->MakeMove<isWhite>(move);
+    m_pBoard->InvalidateCheckPinAndIllegalMoves();
+    m_pBoard->GenerateCheckAndPinMask<!isWhite>();
+
+    Move ttMove = m_pTransTable->ProbeTable(
+        m_pBoard->GetZobKey(), TTQSearchDepth + 1, InitialAlpha, InitialBeta);
+    if ((ttMove.score != TTScoreNotFound) && m_pBoard->IsMoveLegal<!isWhite>(ttMove))
+    {
+        AppendPvMove<!isWhite>(ttMove, pvLength - 1, pPvStr);
+    }
+
+    m_pBoard->UnmakeMove<isWhite>();
+}
+
+bool ChessEngine::GetMoveFromString(const std::string& moveStr, Move* pMove)
+{
+    Move** ppMoveList = m_pppMoveLists[0];
+
+    m_pBoard->InvalidateCheckPinAndIllegalMoves();
+    if (m_pBoard->GetBoardStateIsWhiteTurn())
+    {
+        m_pBoard->GenerateLegalMoves<true, false>(ppMoveList);
+    }
+    else
+    {
+        m_pBoard->GenerateLegalMoves<false, false>(ppMoveList);
+    }
+
+    bool found = false;
+    for (MoveTypes moveType : { MoveTypes::ProbablyGood, MoveTypes::Attack, MoveTypes::Normal })
+    {
+        for (Move* pCurMove = ppMoveList[moveType];
+             (pCurMove->fromPiece != Piece::EndOfMoveList) && (found == false);
+             pCurMove++)
+        {
+            if (m_pBoard->GetStringFromMove(*pCurMove) == moveStr)
+            {
+                *pMove = *pCurMove;
+                found  = true;
+            }
+        }
+    }
+
+    return found;
+}
+
 std::string ChessEngine::ConvertScoreToStr(int32 score, int32* pCheckMateDepth)
 {
     std::string scoreStr = "";
@@ -1070,7 +2001,7 @@ void ChessEngine::SortMoves(Move* pMoveList, const SearchSettings& settings)
             // immediately mark it as the best attack
             if (settings.searchReCaptureFirst)
             {
-                if (pMoveList[j].toPos == m_pBoard->GetLastPosCaptured())
+                if (pMoveList[j].ToPos() == m_pBoard->GetLastPosCaptured())
                 {
                     maxIdx = j;
                     break;
@@ -1106,7 +2037,7 @@ bool ChessEngine::IsMoveGoodForQsearch(
                               (move.toPiece != Piece::bPawn);
     bool isPromotion        = ((move.flags & MoveFlags::Promotion) != 0);
 
-    bool reCapturingPiece   = ((move.toPos & movedPieces) != 0ull);
+    bool reCapturingPiece   = ((move.ToPos() & movedPieces) != 0ull);
     bool belowMaxFreePly    = ply < maxFreePly;
 
     bool isMoveDeltaPruned  = settings.doDeltaPruning                       &&
@@ -1126,9 +2057,9 @@ void ChessEngine::InsertKillerMove(const Move& move, uint32 ply)
         Move* killerMoves = m_pppMoveLists[ply][MoveTypes::Killer];
         Move currKiller = killerMoves[0];
         const bool movesEqual = (move.fromPiece == currKiller.fromPiece) &&
-                                (move.fromPos   == currKiller.fromPos)   &&
+                                (move.fromIdx   == currKiller.fromIdx)   &&
                                 (move.toPiece   == currKiller.toPiece)   &&
-                                (move.toPos     == currKiller.toPos);
+                                (move.toIdx     == currKiller.toIdx);
         if (movesEqual == false)
         {
             memcpy(&(killerMoves[1]), &(killerMoves[0]), sizeof(Move));
@@ -1144,6 +2075,11 @@ void ChessEngine::ResetKillers()
         m_pppMoveLists[ply][MoveTypes::Killer][0].fromPiece = Piece::EndOfMoveList;
         m_pppMoveLists[ply][MoveTypes::Killer][1].fromPiece = Piece::EndOfMoveList;
     }
+
+    for (ChessEngine* pHelper : m_helperEngines)
+    {
+        pHelper->ResetKillers();
+    }
 }
 
 void ChessEngine::InsertCounterMove(const Move& move)
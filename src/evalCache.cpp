@@ -0,0 +1,46 @@
+#include "../inc/evalCache.h"
+#include <algorithm>
+
+EvalCache::EvalCache()
+:
+m_pTable(nullptr),
+m_sizeKB(0),
+m_numEntries(0)
+{
+
+}
+
+EvalCache::~EvalCache()
+{
+
+}
+
+void EvalCache::Init(uint32 sizeKB)
+{
+    constexpr uint64 BytesPerKB = 1024ull;
+
+    Destroy();
+
+    m_sizeKB     = std::max<uint32>(sizeKB, 1);
+    m_numEntries = static_cast<uint32>((m_sizeKB * BytesPerKB) / sizeof(EvalCacheEntry));
+    m_pTable     = new EvalCacheEntry[m_numEntries];
+
+    ResetCache();
+}
+
+void EvalCache::Destroy()
+{
+    delete[] m_pTable;
+    m_pTable     = nullptr;
+    m_numEntries = 0;
+}
+
+// A cleared entry only matches a key of 0, which is as unlikely as any other collision.
+void EvalCache::ResetCache()
+{
+    for (uint32 entryIdx = 0; entryIdx < m_numEntries; entryIdx++)
+    {
+        m_pTable[entryIdx].keyXorData.store(0ull, std::memory_order_relaxed);
+        m_pTable[entryIdx].data.store(0ull, std::memory_order_relaxed);
+    }
+}
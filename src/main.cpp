@@ -13,10 +13,22 @@ int main(int argc, char** argv)
     board.PrintBoard(board.GetAllPieces());
 
     ChessGame game = ChessGame();
-    game.Init();
-    game.Run();
+    if (game.Init() == Result::Error)
+    {
+        return 2;
+    }
+
+    int32 exitCode = 0;
+    if (argc > 1)
+    {
+        exitCode = game.RunCommandLine(argc, argv);
+    }
+    else
+    {
+        game.Run();
+    }
 
     game.Destroy();
 
-    return 0;
+    return exitCode;
 }
\ No newline at end of file
@@ -0,0 +1,300 @@
+#include "../inc/nnue.h"
+#include <intrin.h>
+#include <immintrin.h>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+NnueBackend ActiveNnueBackend = NnueBackend::Scalar;
+
+constexpr uint32 NumNnuePieces = 12;
+
+// Network piece type for each of Board's pieces, which go king to pawn.  The network's go pawn,
+// knight, bishop, rook, queen, king.
+constexpr uint32 NnuePieceTypes[NumNnuePieces] = { 5, 4, 3, 1, 2, 0,
+                                                   5, 4, 3, 1, 2, 0 };
+
+struct NnueFeatureIndexes
+{
+    uint16 index[NumPerspectives][NumNnuePieces][64];
+};
+
+constexpr NnueFeatureIndexes BuildNnueFeatureIndexes()
+{
+    NnueFeatureIndexes indexes = {};
+    for (uint32 piece = 0; piece < NumNnuePieces; piece++)
+    {
+        const uint32 isBlackPiece = (piece >= 6) ? 1 : 0;
+        const uint32 pieceType    = NnuePieceTypes[piece];
+        for (uint32 idx = 0; idx < 64; idx++)
+        {
+            indexes.index[WhitePerspective][piece][idx] =
+                static_cast<uint16>((isBlackPiece * 384) + (pieceType * 64) + idx);
+            indexes.index[BlackPerspective][piece][idx] =
+                static_cast<uint16>(((1 - isBlackPiece) * 384) + (pieceType * 64) + (idx ^ 56));
+        }
+    }
+    return indexes;
+}
+
+constexpr NnueFeatureIndexes NnueFeatureIndex = BuildNnueFeatureIndexes();
+
+bool CpuHasAvx2()
+{
+    // cpuInfo is eax, ebx, ecx, edx
+    int cpuInfo[4] = {};
+
+    __cpuid(cpuInfo, 0);
+    const int maxLeaf = cpuInfo[0];
+    if (maxLeaf < 7)
+    {
+        return false;
+    }
+
+    // The OS has to save the ymm registers on a context switch too: OSXSAVE is bit 27 of ecx in
+    // leaf 1, and XCR0 has to have the xmm and ymm state bits set.
+    __cpuid(cpuInfo, 1);
+    const bool hasOsXsave = (cpuInfo[2] & (1 << 27)) != 0;
+    if (hasOsXsave == false)
+    {
+        return false;
+    }
+
+    const uint64 xcr0 = _xgetbv(0);
+    if ((xcr0 & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    // AVX2 is bit 5 of ebx in leaf 7
+    __cpuidex(cpuInfo, 7, 0);
+    return (cpuInfo[1] & (1 << 5)) != 0;
+}
+
+void SelectNnueBackend()
+{
+    ActiveNnueBackend = CpuHasAvx2() ? NnueBackend::Avx2 : NnueBackend::Scalar;
+}
+
+const char* GetNnueBackendName(NnueBackend backend)
+{
+    switch (backend)
+    {
+        case(NnueBackend::Scalar): return "scalar";
+        case(NnueBackend::Avx2):   return "avx2";
+        default:                   return "unknown";
+    }
+}
+
+NnueNetwork::NnueNetwork()
+:
+m_featureWeights(),
+m_featureBiases(),
+m_outputWeights(),
+m_outputBias(0),
+m_fileName(),
+m_isLoaded(false)
+{
+
+}
+
+NnueNetwork::~NnueNetwork()
+{
+
+}
+
+bool NnueNetwork::LoadFromFile(const char* pFileName)
+{
+    constexpr uint64 NetworkBytes = sizeof(m_featureWeights) +
+                                    sizeof(m_featureBiases)  +
+                                    sizeof(m_outputWeights)  +
+                                    sizeof(m_outputBias);
+    constexpr uint64 PaddedBytes  = (NetworkBytes + 63) & ~63ull;
+
+    m_isLoaded = false;
+    m_fileName.clear();
+
+    std::ifstream netFile(pFileName, std::ios::binary | std::ios::ate);
+    if (netFile.is_open() == false)
+    {
+        return false;
+    }
+
+    const uint64 fileBytes = static_cast<uint64>(netFile.tellg());
+    if ((fileBytes != NetworkBytes) && (fileBytes != PaddedBytes))
+    {
+        std::cout << pFileName << " is " << fileBytes << " bytes, expected " << NetworkBytes
+                  << " for a " << NnueNumInputs << "->" << NnueHiddenSize << "x2->1 network"
+                  << std::endl;
+        return false;
+    }
+
+    netFile.seekg(0);
+    netFile.read(reinterpret_cast<char*>(&(m_featureWeights[0][0])), sizeof(m_featureWeights));
+    netFile.read(reinterpret_cast<char*>(&(m_featureBiases[0])),     sizeof(m_featureBiases));
+    netFile.read(reinterpret_cast<char*>(&(m_outputWeights[0])),     sizeof(m_outputWeights));
+    netFile.read(reinterpret_cast<char*>(&m_outputBias),             sizeof(m_outputBias));
+    if (netFile.fail())
+    {
+        return false;
+    }
+
+    m_fileName = pFileName;
+    m_isLoaded = true;
+    return true;
+}
+
+void NnueNetwork::RefreshAccumulator(const uint8* pMailbox, NnueAccumulator* pAccumulator) const
+{
+    for (uint32 perspective = 0; perspective < NumPerspectives; perspective++)
+    {
+        int16* pValues = &(pAccumulator->values[perspective][0]);
+        memcpy(pValues, &(m_featureBiases[0]), sizeof(m_featureBiases));
+
+        for (uint32 idx = 0; idx < 64; idx++)
+        {
+            const uint32 piece = pMailbox[idx];
+            if (piece >= NumNnuePieces)
+            {
+                continue;
+            }
+
+            const int16* pWeights = &(m_featureWeights[NnueFeatureIndex.index[perspective][piece][idx]][0]);
+            for (uint32 hiddenIdx = 0; hiddenIdx < NnueHiddenSize; hiddenIdx++)
+            {
+                pValues[hiddenIdx] += pWeights[hiddenIdx];
+            }
+        }
+    }
+}
+
+void NnueNetwork::UpdateAccumulator(
+    const NnueAccumulator& parent,
+    const NnueDelta&       delta,
+    NnueAccumulator*       pChild) const
+{
+    if (ActiveNnueBackend == NnueBackend::Avx2)
+    {
+        UpdateAccumulatorWithBackend<NnueBackend::Avx2>(parent, delta, pChild);
+    }
+    else
+    {
+        UpdateAccumulatorWithBackend<NnueBackend::Scalar>(parent, delta, pChild);
+    }
+}
+
+// The weight rows are gathered up front so the inner loop is just adds and subtracts.  Unused
+// rows point at ZeroRow rather than being branched around.
+template<NnueBackend backend>
+void NnueNetwork::UpdateAccumulatorWithBackend(
+    const NnueAccumulator& parent,
+    const NnueDelta&       delta,
+    NnueAccumulator*       pChild) const
+{
+    alignas(64) static constexpr int16 ZeroRow[NnueHiddenSize] = {};
+
+    for (uint32 perspective = 0; perspective < NumPerspectives; perspective++)
+    {
+        const int16* pAdd[2]    = { ZeroRow, ZeroRow };
+        const int16* pRemove[2] = { ZeroRow, ZeroRow };
+        for (uint32 addIdx = 0; addIdx < delta.numAdded; addIdx++)
+        {
+            const uint32 feature = NnueFeatureIndex.index[perspective][delta.addedPiece[addIdx]]
+                                                                     [delta.addedIdx[addIdx]];
+            pAdd[addIdx] = &(m_featureWeights[feature][0]);
+        }
+        for (uint32 removeIdx = 0; removeIdx < delta.numRemoved; removeIdx++)
+        {
+            const uint32 feature = NnueFeatureIndex.index[perspective][delta.removedPiece[removeIdx]]
+                                                                     [delta.removedIdx[removeIdx]];
+            pRemove[removeIdx] = &(m_featureWeights[feature][0]);
+        }
+
+        const int16* pParent = &(parent.values[perspective][0]);
+        int16*       pValues = &(pChild->values[perspective][0]);
+
+        if constexpr (backend == NnueBackend::Avx2)
+        {
+            for (uint32 hiddenIdx = 0; hiddenIdx < NnueHiddenSize; hiddenIdx += 16)
+            {
+                __m256i values = _mm256_load_si256(reinterpret_cast<const __m256i*>(&(pParent[hiddenIdx])));
+                values = _mm256_add_epi16(values, _mm256_load_si256(reinterpret_cast<const __m256i*>(&(pAdd[0][hiddenIdx]))));
+                values = _mm256_add_epi16(values, _mm256_load_si256(reinterpret_cast<const __m256i*>(&(pAdd[1][hiddenIdx]))));
+                values = _mm256_sub_epi16(values, _mm256_load_si256(reinterpret_cast<const __m256i*>(&(pRemove[0][hiddenIdx]))));
+                values = _mm256_sub_epi16(values, _mm256_load_si256(reinterpret_cast<const __m256i*>(&(pRemove[1][hiddenIdx]))));
+                _mm256_store_si256(reinterpret_cast<__m256i*>(&(pValues[hiddenIdx])), values);
+            }
+        }
+        else
+        {
+            for (uint32 hiddenIdx = 0; hiddenIdx < NnueHiddenSize; hiddenIdx++)
+            {
+                pValues[hiddenIdx] = pParent[hiddenIdx] + pAdd[0][hiddenIdx] + pAdd[1][hiddenIdx] -
+                                     pRemove[0][hiddenIdx] - pRemove[1][hiddenIdx];
+            }
+        }
+    }
+}
+
+int32 NnueNetwork::Evaluate(const NnueAccumulator& accumulator, bool isWhiteTurn) const
+{
+    const NnuePerspective us   = (isWhiteTurn) ? WhitePerspective : BlackPerspective;
+    const NnuePerspective them = (isWhiteTurn) ? BlackPerspective : WhitePerspective;
+
+    const int16* pUs   = &(accumulator.values[us][0]);
+    const int16* pThem = &(accumulator.values[them][0]);
+
+    const int32 output = (ActiveNnueBackend == NnueBackend::Avx2) ?
+                         OutputLayerWithBackend<NnueBackend::Avx2>(pUs, pThem) :
+                         OutputLayerWithBackend<NnueBackend::Scalar>(pUs, pThem);
+
+    return ((output + m_outputBias) * NnueEvalScale) / (NnueQuantA * NnueQuantB);
+}
+
+// Clipped ReLU then the dot product with the output weights.  A clipped value times a weight is
+// at most 255 * 32767, so madd's pairs of them still fit in 32 bits.
+template<NnueBackend backend>
+int32 NnueNetwork::OutputLayerWithBackend(const int16* pUs, const int16* pThem) const
+{
+    const int16* pInputs[NumPerspectives] = { pUs, pThem };
+
+    if constexpr (backend == NnueBackend::Avx2)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i qa   = _mm256_set1_epi16(NnueQuantA);
+
+        __m256i sum = _mm256_setzero_si256();
+        for (uint32 perspective = 0; perspective < NumPerspectives; perspective++)
+        {
+            const int16* pWeights = &(m_outputWeights[perspective * NnueHiddenSize]);
+            for (uint32 hiddenIdx = 0; hiddenIdx < NnueHiddenSize; hiddenIdx += 16)
+            {
+                __m256i values = _mm256_load_si256(reinterpret_cast<const __m256i*>(&(pInputs[perspective][hiddenIdx])));
+                values = _mm256_min_epi16(_mm256_max_epi16(values, zero), qa);
+
+                const __m256i weights = _mm256_load_si256(reinterpret_cast<const __m256i*>(&(pWeights[hiddenIdx])));
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(values, weights));
+            }
+        }
+
+        // Add up the 8 lanes.
+        __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(sum128);
+    }
+    else
+    {
+        int32 sum = 0;
+        for (uint32 perspective = 0; perspective < NumPerspectives; perspective++)
+        {
+            const int16* pWeights = &(m_outputWeights[perspective * NnueHiddenSize]);
+            for (uint32 hiddenIdx = 0; hiddenIdx < NnueHiddenSize; hiddenIdx++)
+            {
+                const int32 value = std::clamp<int32>(pInputs[perspective][hiddenIdx], 0, NnueQuantA);
+                sum += value * pWeights[hiddenIdx];
+            }
+        }
+        return sum;
+    }
+}
@@ -0,0 +1,54 @@
+#include "../inc/pawnHashTable.h"
+
+PawnHashTable::PawnHashTable()
+:
+m_pTable(nullptr),
+m_indexMask(0ull),
+m_numProbes(0ull),
+m_numHits(0ull)
+{
+
+}
+
+PawnHashTable::~PawnHashTable()
+{
+
+}
+
+// Rounds numEntries down to a power of 2, so an index is just the low bits of the key.
+void PawnHashTable::Init(uint32 numEntries)
+{
+    Destroy();
+
+    uint64 tableEntries = 1ull;
+    while ((tableEntries * 2) <= numEntries)
+    {
+        tableEntries *= 2;
+    }
+
+    m_pTable    = new PawnHashEntry[tableEntries];
+    m_indexMask = tableEntries - 1;
+
+    ResetTable();
+    ResetStats();
+}
+
+void PawnHashTable::Destroy()
+{
+    delete[] m_pTable;
+    m_pTable    = nullptr;
+    m_indexMask = 0ull;
+}
+
+void PawnHashTable::ResetTable()
+{
+    if (m_pTable == nullptr)
+    {
+        return;
+    }
+
+    for (uint64 entryIdx = 0; entryIdx <= m_indexMask; entryIdx++)
+    {
+        m_pTable[entryIdx] = {};
+    }
+}
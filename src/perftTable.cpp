@@ -0,0 +1,103 @@
+#include "../inc/perftTable.h"
+#include <intrin.h>
+#include <algorithm>
+
+PerftTable::PerftTable()
+:
+m_pTable(nullptr),
+m_sizeMB(0),
+m_numBuckets(0)
+{
+
+}
+
+PerftTable::~PerftTable()
+{
+
+}
+
+void PerftTable::Init(uint32 sizeMB)
+{
+    constexpr uint64 BytesPerMB = 1024ull * 1024ull;
+
+    Destroy();
+
+    m_sizeMB     = std::max<uint32>(sizeMB, 1);
+    m_numBuckets = static_cast<uint32>((m_sizeMB * BytesPerMB) / sizeof(PerftTableBucket));
+    m_pTable     = new PerftTableBucket[m_numBuckets];
+
+    ResetTable();
+}
+
+void PerftTable::Destroy()
+{
+    delete[] m_pTable;
+    m_pTable     = nullptr;
+    m_numBuckets = 0;
+}
+
+void PerftTable::ResetTable()
+{
+    for (uint32 bucketIdx = 0; bucketIdx < m_numBuckets; bucketIdx++)
+    {
+        for (uint32 entryIdx = 0; entryIdx < PerftEntriesPerBucket; entryIdx++)
+        {
+            m_pTable[bucketIdx].entries[entryIdx].keyXorData.store(0ull, std::memory_order_relaxed);
+            m_pTable[bucketIdx].entries[entryIdx].data.store(0ull, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Cleared entries have a depth of 0, which is never probed, so they can't match.
+bool PerftTable::ProbeTable(uint64 zobKey, uint32 depth, uint64* pCount)
+{
+    const PerftTableBucket* pBucket = &(m_pTable[HashZobKey(zobKey)]);
+    const uint64 wantDepth = static_cast<uint64>(depth) << PerftCountBits;
+
+    for (uint32 entryIdx = 0; entryIdx < PerftEntriesPerBucket; entryIdx++)
+    {
+        const PerftTableEntry& entry = pBucket->entries[entryIdx];
+        const uint64 keyXorData = entry.keyXorData.load(std::memory_order_relaxed);
+        const uint64 data       = entry.data.load(std::memory_order_relaxed);
+
+        if (((keyXorData ^ data) == zobKey) && ((data & ~PerftCountMask) == wantDepth))
+        {
+            *pCount = data & PerftCountMask;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Replaces the entry with the smallest count in the bucket, which is the cheapest one to count
+// again.  Empty entries have a count of 0, so they go first.
+void PerftTable::InsertToTable(uint64 zobKey, uint32 depth, uint64 count)
+{
+    PerftTableBucket* pBucket = &(m_pTable[HashZobKey(zobKey)]);
+
+    PerftTableEntry* pReplaceEntry = &(pBucket->entries[0]);
+    uint64           replaceCount  = UINT64_MAX;
+    for (uint32 entryIdx = 0; entryIdx < PerftEntriesPerBucket; entryIdx++)
+    {
+        PerftTableEntry* pEntry = &(pBucket->entries[entryIdx]);
+        const uint64 entryCount = pEntry->data.load(std::memory_order_relaxed) & PerftCountMask;
+        if (entryCount < replaceCount)
+        {
+            pReplaceEntry = pEntry;
+            replaceCount  = entryCount;
+        }
+    }
+
+    CH_ASSERT(count <= PerftCountMask);
+    const uint64 data = (static_cast<uint64>(depth) << PerftCountBits) | (count & PerftCountMask);
+
+    pReplaceEntry->keyXorData.store(zobKey ^ data, std::memory_order_relaxed);
+    pReplaceEntry->data.store(data, std::memory_order_relaxed);
+}
+
+// Same multiply-high indexing as the transposition table.
+uint32 PerftTable::HashZobKey(uint64 zobKey)
+{
+    return static_cast<uint32>(__umulh(zobKey, m_numBuckets));
+}
@@ -0,0 +1,266 @@
+#include "../inc/sliderAttacks.h"
+#include "../inc/bitHelper.h"
+#include <intrin.h>
+#include <mutex>
+
+SliderMagic RookMagics[64];
+SliderMagic BishopMagics[64];
+uint64      RayToSquareTable[64][64];
+
+SliderBackend ActiveSliderBackend = SliderBackend::Magic;
+
+static uint64 RookAttackTable[RookAttackTableSize];
+static uint64 BishopAttackTable[BishopAttackTableSize];
+
+static uint64 RookPextAttackTable[RookAttackTableSize];
+static uint64 BishopPextAttackTable[BishopAttackTableSize];
+
+static constexpr Directions RookDirections[]   = { North, East, South, West };
+static constexpr Directions BishopDirections[] = { NorthEast, NorthWest, SouthEast, SouthWest };
+
+static constexpr uint64 RookMagicNumbers[64] =
+{
+    0x0280001420804001ull, 0x2140014010002000ull, 0x0100200041001008ull, 0x2100200900100004ull,
+    0xC080028004000800ull, 0x0200280200040170ull, 0x0200080100A42200ull, 0x4200022208840045ull,
+    0x8800800080204000ull, 0x2008808040002000ull, 0x6102806000809000ull, 0x0008801000080080ull,
+    0x2300800400800801ull, 0x2008012040080410ull, 0x0084000410080201ull, 0x508200020040A401ull,
+    0x028000C011200040ull, 0x1120808040002002ull, 0x0010002000240800ull, 0x0010008008001084ull,
+    0x0400808008000400ull, 0x8480080140100420ull, 0x2400010100020004ull, 0x0100020000840041ull,
+    0x0240400880208000ull, 0x01401000A0002800ull, 0x0020080040401000ull, 0x0000080080100080ull,
+    0x00A4080100100500ull, 0x0000020080040080ull, 0x2000482400210210ull, 0x0004088200010844ull,
+    0x04A0400020800080ull, 0x0000804002802004ull, 0x8090001080802000ull, 0x0000080082801000ull,
+    0x0492510005002800ull, 0x2202020080800400ull, 0x0000481004002182ull, 0x0200244906000084ull,
+    0x02C000244C848001ull, 0x1000810042020028ull, 0x2830002408002000ull, 0x0208420010220008ull,
+    0x0090040801010010ull, 0x4000020004008080ull, 0x800A000401820008ull, 0xE009141448820001ull,
+    0x1008801240042080ull, 0x4000200840008880ull, 0x1040C46001023100ull, 0x0024080010008480ull,
+    0x0184008088000480ull, 0x0002000408100200ull, 0x1000800200010080ull, 0x0640044403028600ull,
+    0x8340CA0010628102ull, 0x2000208040010011ull, 0x04000A8020401202ull, 0x1104042010000901ull,
+    0x4001001008000285ull, 0x8125000208040001ull, 0x8541410088104204ull, 0x0000040040208112ull
+};
+
+static constexpr uint64 BishopMagicNumbers[64] =
+{
+    0x0028090808045080ull, 0x0103134144050800ull, 0x0004244082000080ull, 0x8124040898600100ull,
+    0x8008484100012002ull, 0x4004220940000030ull, 0x212C310110104108ull, 0x0001A18A08200200ull,
+    0x0480899891082200ull, 0x1100030802008200ull, 0x1001420400408008ull, 0x0428044100204801ull,
+    0x2008420210082022ull, 0x0204043008080083ull, 0x08000982102A2041ull, 0x6280084044042081ull,
+    0x4040000809080080ull, 0x00A1230404341045ull, 0x02D0010204204101ull, 0x0001026804110000ull,
+    0x0204002202118041ull, 0x1002000020902850ull, 0x0081004080905080ull, 0x1040800104008204ull,
+    0x2090100808208144ull, 0x24180408200420A1ull, 0x5080300002040443ull, 0x8120080191004208ull,
+    0x0050101041004000ull, 0x8A00820080221001ull, 0x0000840122220240ull, 0x00088B01120B0090ull,
+    0x8002D01001400208ull, 0x4000B01000882200ull, 0x102040A604100408ull, 0x10820420080C0100ull,
+    0x0681020400080410ull, 0x0005300780050040ull, 0x0004008081421820ull, 0x3102008020010400ull,
+    0x8001084310144000ull, 0x02028814100082A2ull, 0x0201009804044A00ull, 0x8042004010403202ull,
+    0x1100089010100100ull, 0x0020009008820841ull, 0x1024810419004400ull, 0x0301080111001040ull,
+    0x0001080802080220ull, 0x4D05011082200015ull, 0x0020060042080800ull, 0x0600040904882101ull,
+    0x0000000803040028ull, 0x0100202102008000ull, 0x00454882041C0C00ull, 0x00026C8801890100ull,
+    0x2021008084204211ull, 0x9500020904210400ull, 0x2002000044240401ull, 0x0011004000420200ull,
+    0x800A016008210100ull, 0x0C0021B020080129ull, 0x0001202041121080ull, 0x0004010848008080ull
+};
+
+static uint64 StepInDirection(uint64 pos, Directions dir)
+{
+    switch (dir)
+    {
+        case(North):     return MoveUp(pos);
+        case(East):      return MoveRight(pos);
+        case(South):     return MoveDown(pos);
+        case(West):      return MoveLeft(pos);
+        case(NorthEast): return MoveUpRight(pos);
+        case(NorthWest): return MoveUpLeft(pos);
+        case(SouthEast): return MoveDownRight(pos);
+        case(SouthWest): return MoveDownLeft(pos);
+        default:         return 0ull;
+    }
+}
+
+// Walks each ray one square at a time until it hits a blocker.  Pretty slow, should only be used
+// to build the tables.
+static uint64 SlowSliderAttacks(uint32 idx, uint64 occupied, const Directions* pDirs)
+{
+    uint64 attacks = 0ull;
+    for (uint32 dirIdx = 0; dirIdx < 4; dirIdx++)
+    {
+        uint64 pos = IndexToPosition(idx);
+        do
+        {
+            pos = StepInDirection(pos, pDirs[dirIdx]);
+            attacks |= pos;
+        } while ((pos != 0ull) && ((pos & occupied) == 0ull));
+    }
+    return attacks;
+}
+
+// Fills in a square's slice of the attack table for every subset of its blocker mask.  The magics
+// were found offline with a search over sparse random numbers, so all this has to do is verify
+// there are no destructive collisions (two subsets with different attacks landing on one entry)
+// and that the slices fill the table exactly.  Returns false if either check fails.  If pPextTable
+// isn't null, it gets filled in too.
+static bool GenerateMagicTable(
+    SliderMagic*      pMagics,
+    const uint64*     pMagicNumbers,
+    uint64*           pTable,
+    uint64*           pPextTable,
+    uint32            tableSize,
+    const Directions* pDirs)
+{
+    uint64* pAttacks     = pTable;
+    uint64* pPextAttacks = pPextTable;
+    for (uint32 idx = 0; idx < 64; idx++)
+    {
+        SliderMagic* pMagic = &(pMagics[idx]);
+
+        // Pieces on the edge of the board can't block anything, unless we're on that edge too.
+        const uint64 rank  = U64Walls::Bottom << (8 * (idx / 8));
+        const uint64 file  = U64Walls::Left   << (idx % 8);
+        const uint64 edges = ((U64Walls::Bottom | U64Walls::Top)   & ~rank) |
+                             ((U64Walls::Left   | U64Walls::Right) & ~file);
+
+        pMagic->mask         = SlowSliderAttacks(idx, 0ull, pDirs) & ~edges;
+        pMagic->magic        = pMagicNumbers[idx];
+        pMagic->shift        = 64 - PopCount(pMagic->mask);
+        pMagic->pAttacks     = pAttacks;
+        pMagic->pPextAttacks = pPextAttacks;
+
+        const uint32 numSubsets = 1 << PopCount(pMagic->mask);
+        for (uint32 subsetIdx = 0; subsetIdx < numSubsets; subsetIdx++)
+        {
+            pAttacks[subsetIdx] = 0ull;
+        }
+
+        // Enumerate every subset of the mask (Carry-Rippler) and store its attack set.  The
+        // subsets come out in the same order as pext(subset, mask), so the pext index is just the
+        // subset number.
+        uint64 subset    = 0ull;
+        uint32 subsetNum = 0;
+        do
+        {
+            const uint64 attacks  = SlowSliderAttacks(idx, subset, pDirs);
+            const uint32 tableIdx = GetMagicIndex(*pMagic, subset);
+            if ((pAttacks[tableIdx] != 0ull) && (pAttacks[tableIdx] != attacks))
+            {
+                return false;
+            }
+            pAttacks[tableIdx] = attacks;
+
+            if (pPextAttacks != nullptr)
+            {
+                pPextAttacks[subsetNum] = attacks;
+            }
+
+            subsetNum++;
+            subset = (subset - pMagic->mask) & pMagic->mask;
+        } while (subset != 0ull);
+
+        pAttacks += numSubsets;
+        if (pPextAttacks != nullptr)
+        {
+            pPextAttacks += numSubsets;
+        }
+    }
+
+    return (pAttacks == pTable + tableSize);
+}
+
+static void GenerateRayToSquareTable()
+{
+    for (uint32 fromIdx = 0; fromIdx < 64; fromIdx++)
+    {
+        for (uint32 toIdx = 0; toIdx < 64; toIdx++)
+        {
+            RayToSquareTable[fromIdx][toIdx] = 0ull;
+        }
+
+        for (uint32 dir = 0; dir < Directions::Count; dir++)
+        {
+            uint64 pos = IndexToPosition(fromIdx);
+            uint64 ray = 0ull;
+
+            pos = StepInDirection(pos, static_cast<Directions>(dir));
+            while (pos != 0ull)
+            {
+                ray |= pos;
+                RayToSquareTable[fromIdx][GetIndex(pos)] = ray;
+                pos = StepInDirection(pos, static_cast<Directions>(dir));
+            }
+        }
+    }
+}
+
+// Boards can be set up on more than one thread, so the tables are built under a once flag.
+Result InitSliderAttackTables()
+{
+    static std::once_flag tablesInitFlag;
+    static Result         tablesResult = Result::Success;
+
+    std::call_once(tablesInitFlag, []()
+    {
+        const bool hasPext = CpuHasFastPext();
+
+        const bool rookTableValid   = GenerateMagicTable(RookMagics,
+                                                         RookMagicNumbers,
+                                                         RookAttackTable,
+                                                         (hasPext) ? RookPextAttackTable : nullptr,
+                                                         RookAttackTableSize,
+                                                         RookDirections);
+        const bool bishopTableValid = GenerateMagicTable(BishopMagics,
+                                                         BishopMagicNumbers,
+                                                         BishopAttackTable,
+                                                         (hasPext) ? BishopPextAttackTable : nullptr,
+                                                         BishopAttackTableSize,
+                                                         BishopDirections);
+        GenerateRayToSquareTable();
+
+        tablesResult = (rookTableValid && bishopTableValid) ? Result::Success : Result::Error;
+    });
+
+    return tablesResult;
+}
+
+bool CpuHasFastPext()
+{
+    // cpuInfo is eax, ebx, ecx, edx
+    int cpuInfo[4] = {};
+
+    __cpuid(cpuInfo, 0);
+    const int maxLeaf = cpuInfo[0];
+
+    // The vendor string is stored in ebx, edx, ecx order.
+    char vendor[13] = {};
+    memcpy(&(vendor[0]), &(cpuInfo[1]), 4);
+    memcpy(&(vendor[4]), &(cpuInfo[3]), 4);
+    memcpy(&(vendor[8]), &(cpuInfo[2]), 4);
+
+    if (maxLeaf < 7)
+    {
+        return false;
+    }
+
+    // BMI2 is bit 8 of ebx in leaf 7
+    __cpuidex(cpuInfo, 7, 0);
+    const bool hasBmi2 = (cpuInfo[1] & (1 << 8)) != 0;
+
+    __cpuid(cpuInfo, 1);
+    uint32 family = (cpuInfo[0] >> 8) & 0xF;
+    if (family == 0xF)
+    {
+        family += (cpuInfo[0] >> 20) & 0xFF;
+    }
+
+    // Zen 1 and Zen 2 (family 0x17) and older AMD chips run pext in microcode.
+    const bool isAmd    = strcmp(vendor, "AuthenticAMD") == 0;
+    const bool slowPext = isAmd && (family < 0x19);
+
+    return hasBmi2 && (slowPext == false);
+}
+
+const char* GetSliderBackendName(SliderBackend backend)
+{
+    switch (backend)
+    {
+        case(SliderBackend::Ray):   return "ray";
+        case(SliderBackend::Magic): return "magic";
+        case(SliderBackend::Pext):  return "pext";
+        default:                    return "unknown";
+    }
+}
@@ -2,12 +2,35 @@
 #include "../inc/engine.h"
 #include "../inc/bitHelper.h"
 #include <intrin.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#endif
+
+constexpr uint64 HugePageSize = 2ull * 1024ull * 1024ull;
 
 TranspositionTable::TranspositionTable()
 :
 m_pTable(nullptr),
-m_hashVal(0),
-m_tableSize(0)
+m_allocBytes(0),
+m_sizeMB(0),
+m_numBuckets(0),
+m_numaNodes(1),
+m_allocMode(TTAllocMode::Normal),
+m_interleaveNuma(false),
+m_generation(0)
 {
 
 }
@@ -17,27 +40,253 @@ TranspositionTable::~TranspositionTable()
 
 }
 
-void TranspositionTable::Init(uint32 tableSize)
+bool TranspositionTable::Init(uint32 sizeMB, bool interleaveNuma)
+{
+    m_interleaveNuma = interleaveNuma;
+    return SetSizeMB(sizeMB);
+}
+
+void TranspositionTable::Destroy()
+{
+    FreeTable(m_pTable, m_allocBytes, m_allocMode);
+    m_pTable     = nullptr;
+    m_allocBytes = 0;
+    m_numBuckets = 0;
+    m_numaNodes  = 1;
+    m_allocMode  = TTAllocMode::Normal;
+}
+
+// The new table is allocated before the old one is freed, so if it can't be the old one is still
+// there to search with.  With no old table, it halves the size until something fits.
+bool TranspositionTable::SetSizeMB(uint32 sizeMB)
 {
-    m_tableSize = tableSize;
-    m_hashVal = tableSize;
+    constexpr uint64 BytesPerMB = 1024ull * 1024ull;
+
+    const uint32 wantedSizeMB = std::max<uint32>(sizeMB, 1);
+
+    uint32 newSizeMB = wantedSizeMB;
+    bool   allocated = false;
+    while (true)
+    {
+        const uint32 numBuckets =
+            static_cast<uint32>((newSizeMB * BytesPerMB) / sizeof(TransTableBucket));
+
+        uint64      allocBytes = 0;
+        TTAllocMode allocMode  = TTAllocMode::Normal;
+        uint32      numaNodes  = 1;
+        TransTableBucket* pTable = AllocTable(
+            static_cast<uint64>(numBuckets) * sizeof(TransTableBucket), &allocBytes, &allocMode, &numaNodes);
+        if (pTable != nullptr)
+        {
+            Destroy();
+
+            m_pTable     = pTable;
+            m_allocBytes = allocBytes;
+            m_allocMode  = allocMode;
+            m_numaNodes  = numaNodes;
+            m_sizeMB     = newSizeMB;
+            m_numBuckets = numBuckets;
+            m_generation = 0;
+            allocated    = (newSizeMB == wantedSizeMB);
+            break;
+        }
+
+        if ((m_pTable != nullptr) || (newSizeMB == 1))
+        {
+            break;
+        }
+        newSizeMB /= 2;
+    }
 
-    m_pTable = static_cast<TransTableEntry*>(malloc(tableSize * sizeof(TransTableEntry)));
     ResetTable();
+    return allocated;
 }
 
-void TranspositionTable::Destroy()
+#ifdef _WIN32
+
+// Large pages need the "Lock pages in memory" privilege, which the user has to be granted.  This
+// only turns it on for the process if the user already has it.
+static bool EnableLockMemoryPrivilege()
+{
+    HANDLE hToken = nullptr;
+    if (OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &hToken) == 0)
+    {
+        return false;
+    }
+
+    TOKEN_PRIVILEGES privileges = {};
+    privileges.PrivilegeCount           = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+    bool enabled = false;
+    if (LookupPrivilegeValue(nullptr, SE_LOCK_MEMORY_NAME, &(privileges.Privileges[0].Luid)))
+    {
+        // Succeeds even if the privilege wasn't assigned, which is only reported through
+        // GetLastError.
+        AdjustTokenPrivileges(hToken, FALSE, &privileges, 0, nullptr, nullptr);
+        enabled = (GetLastError() == ERROR_SUCCESS);
+    }
+    CloseHandle(hToken);
+
+    return enabled;
+}
+
+// Windows can't interleave one allocation across nodes, ResetTable clearing the table from every
+// core is what spreads it out there.
+TransTableBucket* TranspositionTable::AllocTable(
+    uint64       numBytes,
+    uint64*      pAllocBytes,
+    TTAllocMode* pAllocMode,
+    uint32*      pNumaNodes)
+{
+    const uint64 largePageSize = GetLargePageMinimum();
+
+    void* pMem = nullptr;
+    if ((largePageSize != 0) && EnableLockMemoryPrivilege())
+    {
+        *pAllocBytes = ((numBytes + largePageSize - 1) / largePageSize) * largePageSize;
+        *pAllocMode  = TTAllocMode::LargePages;
+        pMem         = VirtualAlloc(
+            nullptr, *pAllocBytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    }
+
+    // VirtualAlloc is always page aligned, which covers the bucket alignment.
+    if (pMem == nullptr)
+    {
+        *pAllocBytes = numBytes;
+        *pAllocMode  = TTAllocMode::Normal;
+        pMem         = VirtualAlloc(nullptr, *pAllocBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+
+    *pNumaNodes = 1;
+    return static_cast<TransTableBucket*>(pMem);
+}
+
+void TranspositionTable::FreeTable(TransTableBucket* pTable, uint64 allocBytes, TTAllocMode allocMode)
+{
+    if (pTable != nullptr)
+    {
+        VirtualFree(pTable, 0, MEM_RELEASE);
+    }
+}
+
+#else
+
+// Reads the highest node from something like "0-1", or "0" on a single node machine.
+static uint32 GetNumNumaNodes()
+{
+    std::ifstream nodeFile("/sys/devices/system/node/online");
+
+    std::string nodeStr;
+    uint32      numNodes = 1;
+    if (nodeFile >> nodeStr)
+    {
+        const size_t lastNumIdx = nodeStr.find_last_of("-,");
+        const std::string lastNodeStr = (lastNumIdx == std::string::npos) ?
+                                        nodeStr : nodeStr.substr(lastNumIdx + 1);
+        numNodes = std::stoul(lastNodeStr) + 1;
+    }
+
+    return numNodes;
+}
+
+// Has to happen before anything touches the pages, the policy only applies to pages that
+// haven't been faulted in yet.  Goes straight to the syscall so this doesn't need libnuma.
+static uint32 InterleaveNumaNodes(void* pMem, uint64 numBytes)
+{
+    constexpr int32 MpolInterleave = 3;
+
+    const uint32 numNodes = std::min<uint32>(GetNumNumaNodes(), 64);
+    if (numNodes <= 1)
+    {
+        return 1;
+    }
+
+    const uint64 nodeMask = (numNodes == 64) ? FullBoard : ((1ull << numNodes) - 1);
+    const long   result   = syscall(SYS_mbind, pMem, numBytes, MpolInterleave, &nodeMask, 65, 0);
+
+    return (result == 0) ? numNodes : 1;
+}
+
+// Tries for explicit huge pages first, which only works if the admin has reserved some
+// (vm.nr_hugepages).  If not, a 2MB aligned allocation can still be promoted to huge pages by the
+// kernel.
+TransTableBucket* TranspositionTable::AllocTable(
+    uint64       numBytes,
+    uint64*      pAllocBytes,
+    TTAllocMode* pAllocMode,
+    uint32*      pNumaNodes)
+{
+    *pAllocBytes = ((numBytes + HugePageSize - 1) / HugePageSize) * HugePageSize;
+
+    void* pMem = mmap(nullptr,
+                      *pAllocBytes,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                      -1,
+                      0);
+    if (pMem != MAP_FAILED)
+    {
+        *pAllocMode = TTAllocMode::LargePages;
+    }
+    else
+    {
+        pMem = aligned_alloc(HugePageSize, *pAllocBytes);
+        if (pMem == nullptr)
+        {
+            return nullptr;
+        }
+        *pAllocMode = (madvise(pMem, *pAllocBytes, MADV_HUGEPAGE) == 0) ?
+                      TTAllocMode::TransparentHuge : TTAllocMode::Normal;
+    }
+
+    *pNumaNodes = m_interleaveNuma ? InterleaveNumaNodes(pMem, *pAllocBytes) : 1;
+    return static_cast<TransTableBucket*>(pMem);
+}
+
+void TranspositionTable::FreeTable(TransTableBucket* pTable, uint64 allocBytes, TTAllocMode allocMode)
+{
+    if (pTable == nullptr)
+    {
+        return;
+    }
+
+    if (allocMode == TTAllocMode::LargePages)
+    {
+        munmap(pTable, allocBytes);
+    }
+    else
+    {
+        free(pTable);
+    }
+}
+
+#endif
+
+const char* TranspositionTable::GetAllocModeStr()
 {
-    free(m_pTable);
-    m_pTable = nullptr;
+    const char* pModeStr = "normal pages";
+    switch (m_allocMode)
+    {
+        case (TTAllocMode::LargePages):
+            pModeStr = "large pages";
+            break;
+        case (TTAllocMode::TransparentHuge):
+            pModeStr = "transparent huge pages";
+            break;
+        default:
+            break;
+    }
+    return pModeStr;
 }
 
-// Makes the engine ~10% faster
+// Makes the engine ~10% faster.  Buckets are cache line aligned, so this brings in every entry the
+// probe could look at.
 void TranspositionTable::PrefetchEntry(uint64 zobKey)
 {
-    uint32 entryIdx = HashZobKey(zobKey);
-    const char* pEntry = reinterpret_cast<char*>(&(m_pTable[entryIdx]));
-    _mm_prefetch(pEntry, _MM_HINT_NTA);
+    uint32 bucketIdx = HashZobKey(zobKey);
+    const char* pBucket = reinterpret_cast<char*>(&(m_pTable[bucketIdx]));
+    _mm_prefetch(pBucket, _MM_HINT_NTA);
 }
 
 Move TranspositionTable::ProbeTable(
@@ -46,86 +295,292 @@ Move TranspositionTable::ProbeTable(
     int32 alpha, 
     int32 beta)
 {
-    uint32 entryIdx = HashZobKey(zobKey);
+    TransTableBucket* pBucket = &(m_pTable[HashZobKey(zobKey)]);
 
-    TransTableEntry tableEntry = m_pTable[entryIdx];
+    TransTableData tableData  = {};
+    bool           keyMatches = false;
+    for (uint32 entryIdx = 0; entryIdx < TTEntriesPerBucket; entryIdx++)
+    {
+        // Read each half exactly once.  Another thread could write the entry in between the two
+        // loads, which the key check catches.
+        TransTableEntry* pEntry = &(pBucket->entries[entryIdx]);
+        const uint64 keyXorData = pEntry->keyXorData.load(std::memory_order_relaxed);
+        tableData.u64all        = pEntry->data.load(std::memory_order_relaxed);
+
+        keyMatches = (keyXorData ^ tableData.u64all) == zobKey;
+        if (keyMatches)
+        {
+            break;
+        }
+    }
 
     Move move = {};
     move.score = TTScoreNotFound;
     
+    // Qsearch only takes scores from other qsearch entries.  Cutting qsearch off on main search
+    // bounds searched up to 3x as many nodes, but their moves are still good to try first.
+    const bool isDeepEnough = (depth == TTQSearchDepth) ? (tableData.depth == TTQSearchDepth) :
+                                                          (tableData.depth >= depth);
+
     // We found a match
-    if ((tableEntry.zobKey == zobKey) && (tableEntry.depth >= depth))
+    const TTScoreType type = tableData.GetType();
+    if (keyMatches && isDeepEnough)
     {
-        move = TinyMoveToMove(tableEntry.tinyMove);
-        move.score = tableEntry.score;
-        if ((tableEntry.type == TTScoreType::LowerBound) && (move.score <= alpha))
+        move = TinyMoveToMove(tableData.tinyMove);
+        move.score = tableData.score;
+        if ((type == TTScoreType::LowerBound) && (move.score <= alpha))
         {
             move.score = alpha;
         }
-        else if ((tableEntry.type == TTScoreType::UpperBound) && (move.score >= beta))
+        else if ((type == TTScoreType::UpperBound) && (move.score >= beta))
         {
             move.score = beta;
         }
-        else if (tableEntry.type != TTScoreType::Exact)
+        else if (type != TTScoreType::Exact)
         {
             move.score = InvalidScore;
         }
     }
-    else if (tableEntry.zobKey == zobKey)
+    else if (keyMatches)
     {
-        move = TinyMoveToMove(tableEntry.tinyMove);
+        move = TinyMoveToMove(tableData.tinyMove);
         move.score = InvalidScore;
     }
 
     return move;
 }
 
+// How much an entry is worth keeping.  Depth is what it cost to get, every search since it was
+// written costs it 8 plies, and exact scores are worth a bit more than bounds.
+int32 TranspositionTable::GetReplaceValue(const TransTableData& tableData)
+{
+    const int32 age = (m_generation - tableData.GetGeneration()) & TTGenerationMask;
+    const int32 exactBonus = (tableData.GetType() == TTScoreType::Exact) ? 2 : 0;
+
+    return tableData.depth - (8 * age) + exactBonus;
+}
+
 void TranspositionTable::InsertToTable(
     uint64 zobKey,
     int32 depth,
     const Move& move, 
     TTScoreType type)
 {
-    uint32 entryIdx = HashZobKey(zobKey);
-    TransTableEntry* pTableEntry = &(m_pTable[entryIdx]);
-    if (pTableEntry->depth <= depth)
+    TransTableBucket* pBucket = &(m_pTable[HashZobKey(zobKey)]);
+
+    // If the position is already in the bucket it has to go in the same entry, otherwise the
+    // bucket could end up with two answers for one key.  If not, replace the least valuable
+    // entry.  All of this is racy, but the worst that can happen is a worse entry getting
+    // replaced.
+    TransTableEntry* pReplaceEntry = nullptr;
+    TransTableData   replaceData   = {};
+    int32            replaceValue  = INT32_MAX;
+    bool             keyMatches    = false;
+    for (uint32 entryIdx = 0; entryIdx < TTEntriesPerBucket; entryIdx++)
+    {
+        TransTableEntry* pEntry = &(pBucket->entries[entryIdx]);
+
+        TransTableData entryData = {};
+        const uint64 keyXorData = pEntry->keyXorData.load(std::memory_order_relaxed);
+        entryData.u64all        = pEntry->data.load(std::memory_order_relaxed);
+
+        if ((keyXorData ^ entryData.u64all) == zobKey)
+        {
+            pReplaceEntry = pEntry;
+            replaceData   = entryData;
+            keyMatches    = true;
+            break;
+        }
+
+        const int32 entryValue = GetReplaceValue(entryData);
+        if (entryValue < replaceValue)
+        {
+            pReplaceEntry = pEntry;
+            replaceData   = entryData;
+            replaceValue  = entryValue;
+        }
+    }
+
+    // Same position: keep a deeper result from this search unless we're replacing a bound with
+    // an exact score.  A qsearch score only looked at captures, so being exact doesn't make it
+    // better than a main search bound.
+    const bool keepOldEntry = keyMatches                                    &&
+                              (replaceData.depth > depth)                   &&
+                              (replaceData.GetGeneration() == m_generation) &&
+                              ((type != TTScoreType::Exact)                 ||
+                               (depth == TTQSearchDepth)                    ||
+                               (replaceData.GetType() == TTScoreType::Exact));
+    if (keepOldEntry == false)
+    {
+        TransTableData tableData = {};
+        tableData.depth    = depth;
+        tableData.tinyMove = MoveToTinyMove(move);
+        tableData.genBound = static_cast<uint8>(type) | (m_generation << TTGenerationShift);
+        tableData.score    = move.score;
+
+        pReplaceEntry->keyXorData.store(zobKey ^ tableData.u64all, std::memory_order_relaxed);
+        pReplaceEntry->data.store(tableData.u64all, std::memory_order_relaxed);
+    }
+}
+
+uint32 TranspositionTable::GetHashFull()
+{
+    constexpr uint32 NumSampleEntries = 1000;
+    constexpr uint32 NumSampleBuckets = NumSampleEntries / TTEntriesPerBucket;
+
+    const uint32 numBuckets = std::min(NumSampleBuckets, m_numBuckets);
+
+    uint32 numUsed = 0;
+    for (uint32 bucketIdx = 0; bucketIdx < numBuckets; bucketIdx++)
     {
-        TinyMove tinyMove = MoveToTinyMove(move);
-        pTableEntry->depth    = depth;
-        pTableEntry->tinyMove = tinyMove;
-        pTableEntry->type     = type;
-        pTableEntry->zobKey   = zobKey;
-        pTableEntry->score    = move.score;
+        for (uint32 entryIdx = 0; entryIdx < TTEntriesPerBucket; entryIdx++)
+        {
+            const TransTableEntry& entry = m_pTable[bucketIdx].entries[entryIdx];
+
+            TransTableData tableData = {};
+            tableData.u64all = entry.data.load(std::memory_order_relaxed);
+
+            // Cleared entries have a depth of -1
+            if ((tableData.depth >= 0) && (tableData.GetGeneration() == m_generation))
+            {
+                numUsed++;
+            }
+        }
     }
+
+    return (numUsed * 1000) / (numBuckets * TTEntriesPerBucket);
 }
 
+// Treats the key as a fraction in [0, 1) and scales it by the number of buckets, which only
+// takes a multiply instead of the 64 bit divide a modulo needs.  This uses the high bits of the
+// key, and works for any table size.
 uint32 TranspositionTable::HashZobKey(uint64 zobKey)
 {
-    return zobKey % m_tableSize;
+    return static_cast<uint32>(__umulh(zobKey, m_numBuckets));
+}
+
+static volatile uint64 ProbeTimingSink = 0ull;
+
+void TranspositionTable::BenchmarkProbes(uint32 numProbes)
+{
+    constexpr uint32 NumRuns = 3;
+
+    uint64 sink       = 0ull;
+    uint64 mulHiTime  = UINT64_MAX;
+    uint64 moduloTime = UINT64_MAX;
+    for (uint32 run = 0; run < NumRuns; run++)
+    {
+        mulHiTime  = std::min(mulHiTime,  TimeProbes<false>(numProbes, &sink));
+        moduloTime = std::min(moduloTime, TimeProbes<true>(numProbes, &sink));
+    }
+    ProbeTimingSink = sink;
+
+    const float mulHiNs  = static_cast<float>(mulHiTime)  / numProbes;
+    const float moduloNs = static_cast<float>(moduloTime) / numProbes;
+
+    std::cout << "Table size     : " << m_sizeMB << " MB (" << m_numBuckets << " buckets)" << std::endl;
+    std::cout << "Multiply-high  : " << mulHiNs  << " ns/probe" << std::endl;
+    std::cout << "Modulo         : " << moduloNs << " ns/probe" << std::endl;
+}
+
+// Probes a stream of pseudo-random keys.  Each probe's key depends on the last one's result, the
+// same way the search can't probe the next position until it's made the move, so this measures
+// latency rather than how many probes can be in flight at once.
+template<bool useModulo>
+uint64 TranspositionTable::TimeProbes(uint32 numProbes, uint64* pSink)
+{
+    uint64 zobKey = 0x9E3779B97F4A7C15ull;
+    uint64 sink   = 0ull;
+
+    auto startTime = std::chrono::steady_clock::now();
+    for (uint32 probe = 0; probe < numProbes; probe++)
+    {
+        zobKey ^= zobKey << 13;
+        zobKey ^= zobKey >> 7;
+        zobKey ^= zobKey << 17;
+
+        uint32 bucketIdx = 0;
+        if constexpr (useModulo)
+        {
+            bucketIdx = zobKey % m_numBuckets;
+        }
+        else
+        {
+            bucketIdx = HashZobKey(zobKey);
+        }
+
+        const TransTableEntry& entry = m_pTable[bucketIdx].entries[0];
+        const uint64 keyXorData = entry.keyXorData.load(std::memory_order_relaxed);
+        zobKey ^= keyXorData & 1ull;
+        sink   += keyXorData;
+    }
+    auto endTime = std::chrono::steady_clock::now();
+
+    *pSink ^= sink;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+void TranspositionTable::ResetTableEntry(TransTableEntry* pEntry)
+{
+    TransTableData tableData = {};
+    tableData.depth              = -1;
+    tableData.score              = TTScoreNotFound;
+    tableData.genBound           = static_cast<uint8>(TTScoreType::LowerBound);
+    tableData.tinyMove.fromPiece = Piece::NoPiece;
+
+    pEntry->keyXorData.store(FullBoard ^ tableData.u64all, std::memory_order_relaxed);
+    pEntry->data.store(tableData.u64all, std::memory_order_relaxed);
 }
 
-void TranspositionTable::ResetTableEntry(int32 idx)
+void TranspositionTable::ResetBuckets(uint32 firstBucket, uint32 endBucket)
 {
-    m_pTable[idx].depth              = -1;
-    m_pTable[idx].zobKey             = FullBoard;
-    m_pTable[idx].score              = TTScoreNotFound;
-    m_pTable[idx].type               = TTScoreType::LowerBound;
-    m_pTable[idx].tinyMove.fromPiece = Piece::NoPiece;
+    for (uint32 bucketIdx = firstBucket; bucketIdx < endBucket; bucketIdx++)
+    {
+        for (uint32 entryIdx = 0; entryIdx < TTEntriesPerBucket; entryIdx++)
+        {
+            ResetTableEntry(&(m_pTable[bucketIdx].entries[entryIdx]));
+        }
+    }
 }
 
+// A single thread can't write fast enough to keep up with memory bandwidth, so big tables get
+// split across every core.  The first write to a page is also what maps it, so when the table
+// isn't interleaved the pages end up on the nodes of the threads that cleared them.
 void TranspositionTable::ResetTable()
 {
-    for (uint32 idx = 0; idx < m_tableSize; idx++)
+    constexpr uint32 MinBucketsPerThread = (16 * 1024 * 1024) / sizeof(TransTableBucket);
+
+    const uint32 numCores   = std::max<uint32>(std::thread::hardware_concurrency(), 1);
+    const uint32 numThreads = std::clamp<uint32>(m_numBuckets / MinBucketsPerThread, 1, numCores);
+
+    if (numThreads == 1)
+    {
+        ResetBuckets(0, m_numBuckets);
+    }
+    else
     {
-        ResetTableEntry(idx);
+        std::vector<std::thread> resetThreads;
+        const uint32 bucketsPerThread = (m_numBuckets + numThreads - 1) / numThreads;
+        for (uint32 threadIdx = 0; threadIdx < numThreads; threadIdx++)
+        {
+            const uint32 firstBucket = std::min(threadIdx * bucketsPerThread, m_numBuckets);
+            const uint32 endBucket   = std::min(firstBucket + bucketsPerThread, m_numBuckets);
+            resetThreads.emplace_back(
+                [this, firstBucket, endBucket]() { ResetBuckets(firstBucket, endBucket); });
+        }
+
+        for (std::thread& resetThread : resetThreads)
+        {
+            resetThread.join();
+        }
     }
 }
 
 TinyMove TranspositionTable::MoveToTinyMove(const Move& move)
 {
     TinyMove tinyMove = {};
-    tinyMove.fromIdx   = GetIndex(move.fromPos);
-    tinyMove.toIdx     = GetIndex(move.toPos);
+    tinyMove.fromIdx   = move.fromIdx;
+    tinyMove.toIdx     = move.toIdx;
     tinyMove.fromPiece = move.fromPiece;
     tinyMove.toPiece   = move.toPiece;
     tinyMove.flags     = move.flags;
@@ -136,11 +591,11 @@ TinyMove TranspositionTable::MoveToTinyMove(const Move& move)
 Move TranspositionTable::TinyMoveToMove(const TinyMove& tinyMove)
 {
     Move move = {};
-    move.fromPos   = IndexToPosition(tinyMove.fromIdx);
-    move.toPos     = IndexToPosition(tinyMove.toIdx);
+    move.fromIdx   = static_cast<uint8>(tinyMove.fromIdx);
+    move.toIdx     = static_cast<uint8>(tinyMove.toIdx);
     move.fromPiece = static_cast<Piece>(tinyMove.fromPiece);
     move.toPiece   = static_cast<Piece>(tinyMove.toPiece);
-    move.flags     = tinyMove.flags;
+    move.flags     = static_cast<uint16>(tinyMove.flags);
 
     return move;
 }
\ No newline at end of file